@@ -0,0 +1,26 @@
+#include "Block.h"
+
+namespace hack {
+std::unique_ptr<Block> Block::Translate(const std::vector<Instruction>& program, uint16_t entry)
+{
+	auto block = std::make_unique<Block>();
+	block->entry = entry;
+	block->length = 0;
+	size_t pc = entry;
+	while (pc < program.size() && block->code.size() < MAX_INSTRUCTIONS)
+	{
+		const Instruction& inst = program[pc];
+		// Halting is left to the interpreter, which stops instead of looping forever.
+		if (inst.op == Op::HALT)
+			break;
+		block->code.push_back(inst);
+		block->length += inst.length;
+		pc += inst.length;
+		if (inst.jump != 0)
+			break;
+	}
+	if (block->code.empty())
+		return nullptr;
+	return block;
+}
+} // namespace hack
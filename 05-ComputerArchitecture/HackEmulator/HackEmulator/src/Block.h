@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Decoder.h"
+
+namespace hack {
+/*
+* A basic block translated for execution as a unit: the predecoded
+* instructions from an entry address up to and including the first one
+* that may jump. While one runs, the emulator keeps A and D in locals
+* and updates PC and the cycle count only once it leaves the block.
+*/
+struct Block
+{
+	// Longest run of instructions translated into a single block.
+	static const size_t MAX_INSTRUCTIONS = 64;
+
+	uint16_t entry;
+	// Number of ROM words, and so clock cycles, executed by the whole block.
+	uint32_t length;
+	// Only the last instruction may jump.
+	std::vector<Instruction> code;
+
+	// Translates the instructions of program starting at entry, or nullptr if none can run as a block.
+	static std::unique_ptr<Block> Translate(const std::vector<Instruction>& program, uint16_t entry);
+};
+} // namespace hack
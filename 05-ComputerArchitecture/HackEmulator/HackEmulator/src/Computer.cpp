@@ -0,0 +1,230 @@
+#include <algorithm>		// std::fill
+#include <fstream>
+#include "Computer.h"
+#include "EmulatorError.h"
+#include "Profiler.h"
+
+namespace hack {
+// RAM address of the stack pointer used by the fused stack idioms.
+static const uint16_t SP = 0;
+
+const uint8_t Computer::s_HOT_THRESHOLD = 16;
+
+Computer::Computer()
+	:m_ROM(MEMORY_SIZE, 0), m_RAM(MEMORY_SIZE, 0), m_A{ 0 }, m_D{ 0 }, m_PC{ 0 },
+	m_Cycles{ 0 }, m_Halted{ false }, m_Translate{ true }, m_Profiler{ nullptr }
+{
+	m_Plain = Decoder::Decode(m_ROM);
+	m_Program = m_Plain;
+}
+
+void Computer::Load(const std::string& path, bool fuse, bool translate)
+{
+	std::ifstream ifs{ path };
+	if (!ifs)
+		throw std::ifstream::failure("Problem encountered while opening \"" + path + "\"");
+	std::vector<uint16_t> rom;
+	std::string line;
+	while (std::getline(ifs, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		if (line.empty())
+			continue;
+		if (line.size() != 16 || line.find_first_not_of("01") != std::string::npos)
+			throw EmulatorError("Invalid instruction \"" + line + "\" at ROM address " + std::to_string(rom.size()));
+		if (rom.size() == MEMORY_SIZE)
+			throw EmulatorError("Program does not fit in 32K ROM");
+		rom.push_back(static_cast<uint16_t>(std::stoi(line, nullptr, 2)));
+	}
+	// Unused ROM reads as 0, i.e. "@0".
+	rom.resize(MEMORY_SIZE, 0);
+	m_ROM = rom;
+	m_Plain = Decoder::Decode(m_ROM);
+	m_Program = fuse ? Decoder::Fuse(m_ROM) : m_Plain;
+	m_Translate = translate;
+	m_Blocks.clear();
+	m_Blocks.resize(MEMORY_SIZE);
+	m_Heat.assign(MEMORY_SIZE, 0);
+	Reset();
+}
+
+void Computer::Reset()
+{
+	std::fill(m_RAM.begin(), m_RAM.end(), 0);
+	m_Screen.ClearDirty();
+	m_A = m_D = m_PC = 0;
+	m_Cycles = 0;
+	m_Halted = false;
+}
+
+/*
+* A superinstruction or block only runs if all of its cycles fit in the
+* budget; otherwise its first instruction runs alone, so the machine can
+* stop on any cycle, as the real one would.
+*/
+uint64_t Computer::Run(uint64_t cycles)
+{
+	const uint64_t start = m_Cycles;
+	const uint64_t limit = start + cycles;
+	while (!m_Halted && m_Cycles < limit)
+	{
+		if (m_Translate)
+		{
+			const Block* block = m_Blocks[m_PC].get();
+			if (!block && ++m_Heat[m_PC] == s_HOT_THRESHOLD)
+				block = (m_Blocks[m_PC] = Block::Translate(m_Program, m_PC)).get();
+			if (block && m_Cycles + block->length <= limit)
+			{
+				RunBlock(*block);
+				continue;
+			}
+		}
+		const Instruction& inst = m_Program[m_PC];
+		if (inst.op == Op::HALT)
+		{	// The loop would never end; no cycles are counted for it.
+			m_Halted = true;
+			break;
+		}
+		const Instruction& next = (m_Cycles + inst.length <= limit) ? inst : m_Plain[m_PC];
+		const uint16_t pc = m_PC;
+		m_PC = Execute(next, pc, m_A, m_D) & ADDRESS_MASK;
+		m_Cycles += next.length;
+		if (m_Profiler)
+			m_Profiler->Count(*this, next.length, (pc + next.length) & ADDRESS_MASK, m_PC);
+	}
+	return m_Cycles - start;
+}
+
+void Computer::RunBlock(const Block& block)
+{
+	uint16_t a = m_A;
+	uint16_t d = m_D;
+	uint16_t pc = block.entry;
+	for (const Instruction& inst : block.code)
+		pc = Execute(inst, pc, a, d);
+	m_A = a;
+	m_D = d;
+	m_PC = pc & ADDRESS_MASK;
+	m_Cycles += block.length;
+	if (m_Profiler)
+		m_Profiler->Count(*this, block.length, (block.entry + block.length) & ADDRESS_MASK, m_PC);
+}
+
+inline uint16_t Computer::Execute(const Instruction& inst, uint16_t pc, uint16_t& a, uint16_t& d)
+{
+	switch (inst.op)
+	{
+	case Op::LOAD_A:
+		a = inst.value;
+		return pc + 1;
+	case Op::COMPUTE:
+		return Compute(inst, pc + 1, a, d);
+	case Op::LOAD_COMPUTE:
+		a = inst.value;
+		return Compute(inst, pc + 2, a, d);
+	case Op::PUSH_D:
+		PushD(a, d);
+		return pc + 5;
+	case Op::COMPUTE_PUSH_D:
+		Compute(inst, pc, a, d);
+		PushD(a, d);
+		return pc + 6;
+	case Op::LOAD_COMPUTE_PUSH_D:
+		a = inst.value;
+		Compute(inst, pc, a, d);
+		PushD(a, d);
+		return pc + 7;
+	case Op::POP_D:
+		PopD(a, d);
+		return pc + 4;
+	case Op::POP_D_LOAD_COMPUTE:
+		PopD(a, d);
+		a = inst.value;
+		return Compute(inst, pc + 6, a, d);
+	case Op::POP_COMPUTE:
+		PopA(a);
+		return Compute(inst, pc + 4, a, d);
+	case Op::BINARY:
+		PopD(a, d);
+		PopA(a);
+		Compute(inst, pc, a, d);
+		Write(SP, Read(SP) + 1);
+		a = SP;
+		return pc + 10;
+	default:	// HALT is handled by Run().
+		return pc;
+	}
+}
+
+// RAM[SP] = D; SP++
+inline void Computer::PushD(uint16_t& a, uint16_t d)
+{
+	uint16_t sp = Read(SP);
+	Write(sp, d);
+	Write(SP, sp + 1);
+	a = SP;
+}
+
+// SP--; A = SP
+inline void Computer::PopA(uint16_t& a)
+{
+	a = Read(SP) - 1;
+	Write(SP, a);
+}
+
+// SP--; D = RAM[SP]
+inline void Computer::PopD(uint16_t& a, uint16_t& d)
+{
+	PopA(a);
+	d = Read(a);
+}
+
+inline uint16_t Computer::Compute(const Instruction& inst, uint16_t next, uint16_t& a, uint16_t& d)
+{
+	uint16_t x = d;
+	uint16_t y = (inst.comp & 0b1000000) ? Read(a) : a;
+	uint16_t out;
+	// Common computations first; anything else goes through the ALU control bits.
+	switch (inst.comp & 0b111111)
+	{
+	case 0b101010: out = 0; break;
+	case 0b111111: out = 1; break;
+	case 0b111010: out = 0xFFFF; break;
+	case 0b001100: out = x; break;
+	case 0b110000: out = y; break;
+	case 0b001101: out = ~x; break;
+	case 0b110001: out = ~y; break;
+	case 0b001111: out = -x; break;
+	case 0b110011: out = -y; break;
+	case 0b011111: out = x + 1; break;
+	case 0b110111: out = y + 1; break;
+	case 0b001110: out = x - 1; break;
+	case 0b110010: out = y - 1; break;
+	case 0b000010: out = x + y; break;
+	case 0b010011: out = x - y; break;
+	case 0b000111: out = y - x; break;
+	case 0b000000: out = x & y; break;
+	case 0b010101: out = x | y; break;
+	default:
+		if (inst.comp & 0b100000) x = 0;		// zx
+		if (inst.comp & 0b010000) x = ~x;		// nx
+		if (inst.comp & 0b001000) y = 0;		// zy
+		if (inst.comp & 0b000100) y = ~y;		// ny
+		out = (inst.comp & 0b000010) ? x + y : x & y;	// f
+		if (inst.comp & 0b000001) out = ~out;	// no
+	}
+	// Jump target and M address are the A register before this instruction.
+	const uint16_t address = a;
+	if (inst.dest & 0b001)
+		Write(address, out);
+	if (inst.dest & 0b100)
+		a = out;
+	if (inst.dest & 0b010)
+		d = out;
+	const int16_t value = static_cast<int16_t>(out);
+	bool jump = ((inst.jump & 0b100) && value < 0) || ((inst.jump & 0b010) && value == 0) ||
+		((inst.jump & 0b001) && value > 0);
+	return jump ? address : next;
+}
+} // namespace hack
@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Decoder.h"
+#include "Block.h"
+#include "Screen.h"
+
+namespace hack {
+class Profiler;
+
+/*
+* The Computer emulates the Hack platform: a 32K ROM holding the program,
+* the data memory (RAM, screen and keyboard memory maps), and the CPU with
+* its A, D and PC registers. Each instruction takes one clock cycle.
+*
+* Code that runs often is translated into Blocks, which execute without
+* checking the cycle budget or updating PC between their instructions.
+*/
+class Computer
+{
+public:
+	// Memory-mapped I/O base addresses.
+	static const uint16_t SCREEN = 16384;
+	static const uint16_t KBD = 24576;
+	// ROM and data memory are both addressed by 15 bits.
+	static const size_t MEMORY_SIZE = 32768;
+public:
+	Computer();
+	/*
+	* Loads Hack machine code (.hack) into ROM. fuse selects superinstruction
+	* predecoding, and translate the translation of hot code into Blocks.
+	*/
+	void Load(const std::string& path, bool fuse = true, bool translate = true);
+	// Clears registers, data memory and the cycle count.
+	void Reset();
+	// Runs until halted or 'cycles' more clock cycles elapse; returns cycles run.
+	uint64_t Run(uint64_t cycles);
+	bool Halted() const { return m_Halted; }
+	uint64_t Cycles() const { return m_Cycles; }
+	uint16_t PC() const { return m_PC; }
+	int16_t A() const { return m_A; }
+	int16_t D() const { return m_D; }
+	int16_t Peek(uint16_t address) const { return m_RAM[address & ADDRESS_MASK]; }
+	void Poke(uint16_t address, int16_t value) { Write(address, value); }
+	// Words of the screen memory map changed since its dirty words were last cleared.
+	Screen& GetScreen() { return m_Screen; }
+	// Has profiler count the cycles run from now on; nullptr stops profiling.
+	void SetProfiler(Profiler* profiler) { m_Profiler = profiler; }
+private:
+	static const uint16_t ADDRESS_MASK = MEMORY_SIZE - 1;
+	// Times execution reaches an address before a Block is translated from it.
+	static const uint8_t s_HOT_THRESHOLD;
+
+	// Raw program, one word per instruction, padded to the full ROM.
+	std::vector<uint16_t> m_ROM;
+	// Each ROM word decoded on its own.
+	std::vector<Instruction> m_Plain;
+	// ROM decoded with superinstructions wherever an idiom starts.
+	std::vector<Instruction> m_Program;
+	std::vector<uint16_t> m_RAM;
+	Screen m_Screen;
+	uint16_t m_A;
+	uint16_t m_D;
+	uint16_t m_PC;
+	uint64_t m_Cycles;
+	bool m_Halted;
+	bool m_Translate;
+	// Block translated from each entry address, if any.
+	std::vector<std::unique_ptr<Block>> m_Blocks;
+	// Times the interpreter reached each address.
+	std::vector<uint8_t> m_Heat;
+	Profiler* m_Profiler;
+
+	void RunBlock(const Block& block);
+	/*
+	* Executes inst (possibly fused) found at pc, on registers a and d;
+	* returns the address of the next instruction. Does not handle HALT.
+	*/
+	uint16_t Execute(const Instruction& inst, uint16_t pc, uint16_t& a, uint16_t& d);
+	// Executes the C-instruction fields of inst; next is the PC if no jump is taken.
+	uint16_t Compute(const Instruction& inst, uint16_t next, uint16_t& a, uint16_t& d);
+	// Execute the translator's stack idioms.
+	void PushD(uint16_t& a, uint16_t d);	// @SP, A=M, M=D, @SP, M=M+1
+	void PopA(uint16_t& a);					// @SP, M=M-1, A=M
+	void PopD(uint16_t& a, uint16_t& d);	// @SP, M=M-1, A=M, D=M
+	uint16_t Read(uint16_t address) const { return m_RAM[address & ADDRESS_MASK]; }
+	// Every store to data memory goes through here, so none to the screen map goes unnoticed.
+	void Write(uint16_t address, uint16_t value)
+	{
+		address &= ADDRESS_MASK;
+		uint16_t offset = address - SCREEN;
+		if (offset < Screen::WORDS && m_RAM[address] != value)
+			m_Screen.MarkDirty(offset);
+		m_RAM[address] = value;
+	}
+};
+} // namespace hack
@@ -0,0 +1,158 @@
+#ifdef _WIN32
+#include <conio.h>
+#else
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+#include "Console.h"
+#include "Keyboard.h"
+
+namespace hack {
+#ifdef _WIN32
+struct Console::Saved
+{
+};
+
+Console::Console()
+	:m_Saved{ std::make_unique<Saved>() }
+{
+}
+
+Console::~Console() = default;
+
+int Console::ReadKey()
+{
+	if (!_kbhit())
+		return 0;
+	int c = _getch();
+	if (c == 0 || c == 224)
+	{	// Extended key: the scan code follows.
+		switch (c = _getch())
+		{
+		case 71: return Keyboard::HOME;
+		case 72: return Keyboard::UP_ARROW;
+		case 73: return Keyboard::PAGE_UP;
+		case 75: return Keyboard::LEFT_ARROW;
+		case 77: return Keyboard::RIGHT_ARROW;
+		case 79: return Keyboard::END;
+		case 80: return Keyboard::DOWN_ARROW;
+		case 81: return Keyboard::PAGE_DOWN;
+		case 82: return Keyboard::INSERT;
+		case 83: return Keyboard::DEL;
+		case 133: return Keyboard::F1 + 10;
+		case 134: return Keyboard::F1 + 11;
+		default: return (c >= 59 && c <= 68) ? Keyboard::F1 + (c - 59) : 0;
+		}
+	}
+	switch (c)
+	{
+	case 3: return STOP;
+	case '\r': return Keyboard::NEWLINE;
+	case '\b': return Keyboard::BACKSPACE;
+	case 27: return Keyboard::ESC;
+	default: return (c >= ' ' && c <= '~') ? c : 0;
+	}
+}
+#else
+struct Console::Saved
+{
+	termios settings;
+	bool restore;
+};
+
+// Next byte of input, or -1 if none arrives within timeout milliseconds.
+static int NextByte(int timeout)
+{
+	pollfd fd{ STDIN_FILENO, POLLIN, 0 };
+	if (poll(&fd, 1, timeout) <= 0)
+		return -1;
+	unsigned char c;
+	// Readable but empty is the end of input.
+	return (read(STDIN_FILENO, &c, 1) == 1) ? c : 4;
+}
+
+// Key code for the rest of an "ESC [" sequence.
+static int ReadCSI()
+{
+	int c = NextByte(10);
+	switch (c)
+	{
+	case 'A': return Keyboard::UP_ARROW;
+	case 'B': return Keyboard::DOWN_ARROW;
+	case 'C': return Keyboard::RIGHT_ARROW;
+	case 'D': return Keyboard::LEFT_ARROW;
+	case 'H': return Keyboard::HOME;
+	case 'F': return Keyboard::END;
+	}
+	// "ESC [ n ~" for the editing and function keys.
+	int n = 0;
+	for (; c >= '0' && c <= '9'; c = NextByte(10))
+		n = n * 10 + (c - '0');
+	if (c != '~')
+		return 0;
+	switch (n)
+	{
+	case 1: case 7: return Keyboard::HOME;
+	case 2: return Keyboard::INSERT;
+	case 3: return Keyboard::DEL;
+	case 4: case 8: return Keyboard::END;
+	case 5: return Keyboard::PAGE_UP;
+	case 6: return Keyboard::PAGE_DOWN;
+	case 23: case 24: return Keyboard::F1 + 10 + (n - 23);
+	}
+	if (n >= 11 && n <= 15)
+		return Keyboard::F1 + (n - 11);
+	if (n >= 17 && n <= 21)
+		return Keyboard::F1 + 5 + (n - 17);
+	return 0;
+}
+
+// Non-canonical input without echo or signals, so Ctrl-C reaches ReadKey().
+Console::Console()
+	:m_Saved{ std::make_unique<Saved>() }
+{
+	m_Saved->restore = (tcgetattr(STDIN_FILENO, &m_Saved->settings) == 0);
+	if (m_Saved->restore)
+	{
+		termios raw = m_Saved->settings;
+		raw.c_lflag &= ~(ICANON | ECHO | ISIG);
+		raw.c_cc[VMIN] = 1;
+		raw.c_cc[VTIME] = 0;
+		tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+	}
+}
+
+Console::~Console()
+{
+	if (m_Saved->restore)
+		tcsetattr(STDIN_FILENO, TCSANOW, &m_Saved->settings);
+}
+
+int Console::ReadKey()
+{
+	int c = NextByte(0);
+	switch (c)
+	{
+	case -1: return 0;
+	case 3: case 4: return STOP;
+	case '\r': case '\n': return Keyboard::NEWLINE;
+	case '\b': case 127: return Keyboard::BACKSPACE;
+	case 27:
+		// A lone ESC is the key itself; otherwise a sequence follows at once.
+		switch (NextByte(10))
+		{
+		case -1: return Keyboard::ESC;
+		case '[': return ReadCSI();
+		case 'O':
+			c = NextByte(10);
+			if (c >= 'P' && c <= 'S')
+				return Keyboard::F1 + (c - 'P');
+			return (c == 'H') ? Keyboard::HOME : (c == 'F') ? Keyboard::END : 0;
+		default: return 0;
+		}
+	default: return (c >= ' ' && c <= '~') ? c : 0;
+	}
+}
+#endif
+} // namespace hack
@@ -0,0 +1,30 @@
+#pragma once
+#include <memory>
+
+namespace hack {
+/*
+* Reads keys from the terminal as they are typed, without echo or waiting
+* for a newline, and translates them to Hack key codes. The terminal is
+* put back as it was when the Console is destroyed.
+*
+* Terminals report key presses but not releases, so it is up to the
+* caller to decide how long a key stays down.
+*/
+class Console
+{
+public:
+	// Returned by ReadKey() once the user asks to stop (Ctrl-C or end of input).
+	static const int STOP = -1;
+public:
+	Console();
+	~Console();
+	Console(const Console&) = delete;
+	Console& operator=(const Console&) = delete;
+	// Hack key code of the next key typed, 0 if none is waiting, or STOP.
+	int ReadKey();
+private:
+	// Terminal settings to restore, as stored by the platform.
+	struct Saved;
+	std::unique_ptr<Saved> m_Saved;
+};
+} // namespace hack
@@ -0,0 +1,118 @@
+#include <algorithm>		// std::equal, std::any_of
+#include "Decoder.h"
+
+namespace hack {
+// Binary codes of the instructions that make up the translator idioms below.
+static const uint16_t AT_SP = 0;						// @SP
+static const uint16_t M_DEC = 0b111'1'110010'001'000;	// M=M-1
+static const uint16_t M_INC = 0b111'1'110111'001'000;	// M=M+1
+static const uint16_t A_EQ_M = 0b111'1'110000'100'000;	// A=M
+static const uint16_t D_EQ_M = 0b111'1'110000'010'000;	// D=M
+static const uint16_t M_EQ_D = 0b111'0'001100'001'000;	// M=D
+
+// Stack idioms emitted by the VM translator for every push and pop.
+static const std::vector<uint16_t> PUSH_D_WORDS = { AT_SP, A_EQ_M, M_EQ_D, AT_SP, M_INC };
+static const std::vector<uint16_t> POP_D_WORDS = { AT_SP, M_DEC, A_EQ_M, D_EQ_M };
+static const std::vector<uint16_t> POP_A_WORDS = { AT_SP, M_DEC, A_EQ_M };
+static const std::vector<uint16_t> INC_SP_WORDS = { AT_SP, M_INC };
+
+Instruction Decoder::DecodeWord(uint16_t word)
+{
+	if (!IsCompute(word))
+		return { Op::LOAD_A, 1, 0, 0, 0, word };
+	uint8_t comp = (word >> 6) & 0b1111111;
+	uint8_t dest = (word >> 3) & 0b111;
+	uint8_t jump = word & 0b111;
+	return { Op::COMPUTE, 1, comp, dest, jump, 0 };
+}
+
+std::vector<Instruction> Decoder::Decode(const std::vector<uint16_t>& rom)
+{
+	std::vector<Instruction> program;
+	program.reserve(rom.size());
+	for (uint16_t word : rom)
+		program.push_back(DecodeWord(word));
+	// Unconditional jump to itself with no side effects never ends.
+	for (size_t pc = 0; pc + 1 < rom.size(); pc++)
+		if (rom[pc] == pc && IsCompute(rom[pc + 1]) && program[pc + 1].dest == 0 &&
+			program[pc + 1].jump == 0b111)
+			program[pc] = { Op::HALT, 2, 0, 0, 0, rom[pc] };
+	return program;
+}
+
+std::vector<Instruction> Decoder::Fuse(const std::vector<uint16_t>& rom)
+{
+	std::vector<Instruction> program = Decode(rom);
+	std::vector<bool> leaders = FindLeaders(rom);
+	const size_t size = rom.size();
+	// An idiom may only span [pc, pc + len) if no jump lands strictly inside it.
+	auto within_block = [&](size_t pc, size_t len) {
+		return pc + len <= size && std::none_of(leaders.begin() + pc + 1,
+			leaders.begin() + pc + len, [](bool leader) { return leader; });
+	};
+	auto matches = [&](size_t pc, const std::vector<uint16_t>& words) {
+		return pc + words.size() <= size && std::equal(words.begin(), words.end(), rom.begin() + pc);
+	};
+	auto computes = [&](size_t pc) {
+		return pc < size && IsCompute(rom[pc]) && !IsJump(rom[pc]);
+	};
+	auto loads_and_computes = [&](size_t pc) {
+		return pc + 1 < size && !IsCompute(rom[pc]) && IsCompute(rom[pc + 1]);
+	};
+	// Superinstruction op at pc, with the fields of the C-instruction at from.
+	auto fuse = [&](size_t pc, size_t from, Op op, size_t len, uint16_t value) {
+		Instruction inst = program[from];
+		inst.op = op;
+		inst.length = static_cast<uint8_t>(len);
+		inst.value = value;
+		program[pc] = inst;
+	};
+	for (size_t pc = 0; pc < size; pc++)
+	{
+		if (program[pc].op == Op::HALT)
+			continue;
+		// Two operands popped and the result pushed back, as in "add" or "and".
+		if (within_block(pc, 10) && matches(pc, POP_D_WORDS) && matches(pc + 4, POP_A_WORDS) &&
+			computes(pc + 7) && matches(pc + 8, INC_SP_WORDS))
+			fuse(pc, pc + 7, Op::BINARY, 10, 0);
+		// Value popped into D, then stored or tested, as in "pop static i" or "if-goto".
+		else if (within_block(pc, 6) && matches(pc, POP_D_WORDS) && loads_and_computes(pc + 4))
+			fuse(pc, pc + 5, Op::POP_D_LOAD_COMPUTE, 6, rom[pc + 4]);
+		else if (within_block(pc, 4) && matches(pc, POP_D_WORDS))
+			program[pc] = { Op::POP_D, 4, 0, 0, 0, 0 };
+		else if (within_block(pc, 5) && matches(pc, PUSH_D_WORDS))
+			program[pc] = { Op::PUSH_D, 5, 0, 0, 0, 0 };
+		// Value computed into D and pushed, as in "push segment index".
+		else if (within_block(pc, 7) && loads_and_computes(pc) && computes(pc + 1) &&
+			matches(pc + 2, PUSH_D_WORDS))
+			fuse(pc, pc + 1, Op::LOAD_COMPUTE_PUSH_D, 7, rom[pc]);
+		else if (within_block(pc, 6) && computes(pc) && matches(pc + 1, PUSH_D_WORDS))
+			fuse(pc, pc, Op::COMPUTE_PUSH_D, 6, 0);
+		// Address popped into A, then operated on, as in "not" or "neg".
+		else if (within_block(pc, 4) && matches(pc, POP_A_WORDS) && IsCompute(rom[pc + 3]))
+			fuse(pc, pc + 3, Op::POP_COMPUTE, 4, 0);
+		// Address (or constant) followed by an instruction that uses it.
+		else if (within_block(pc, 2) && loads_and_computes(pc))
+			fuse(pc, pc + 1, Op::LOAD_COMPUTE, 2, rom[pc]);
+	}
+	return program;
+}
+
+std::vector<bool> Decoder::FindLeaders(const std::vector<uint16_t>& rom)
+{
+	std::vector<bool> leaders(rom.size(), false);
+	if (!rom.empty())
+		leaders[0] = true;
+	for (size_t pc = 0; pc < rom.size(); pc++)
+	{
+		if (!IsJump(rom[pc]))
+			continue;
+		if (pc + 1 < rom.size())
+			leaders[pc + 1] = true;
+		// Target of "@label; D;Jxx" is known statically; computed jumps (A=M) are not.
+		if (pc > 0 && !IsCompute(rom[pc - 1]) && rom[pc - 1] < rom.size())
+			leaders[rom[pc - 1]] = true;
+	}
+	return leaders;
+}
+} // namespace hack
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace hack {
+/* Operations a predecoded instruction may perform. */
+enum class Op : uint8_t
+{
+	LOAD_A,			// @value
+	COMPUTE,		// dest=comp;jump
+	HALT,			// (END) @END 0;JMP
+	// Superinstructions fused from VM translator idioms.
+	LOAD_COMPUTE,	// @value, dest=comp;jump
+	PUSH_D,			// @SP, A=M, M=D, @SP, M=M+1
+	COMPUTE_PUSH_D,	// dest=comp, PUSH_D
+	LOAD_COMPUTE_PUSH_D,	// @value, dest=comp, PUSH_D
+	POP_D,			// @SP, M=M-1, A=M, D=M
+	POP_D_LOAD_COMPUTE,	// POP_D, @value, dest=comp;jump
+	POP_COMPUTE,	// @SP, M=M-1, A=M, dest=comp;jump
+	BINARY			// POP_D, POP_COMPUTE, @SP, M=M+1
+};
+
+/*
+* A Hack instruction (or a fused run of them) decoded ahead of execution,
+* so that the emulator never has to pick apart the bits of a ROM word twice.
+*/
+struct Instruction
+{
+	Op op;
+	// Number of ROM words (and clock cycles) covered by this instruction.
+	uint8_t length;
+	// C-instruction fields: a-bit and c1..c6 (comp), d1..d3 (dest), j1..j3 (jump).
+	uint8_t comp;
+	uint8_t dest;
+	uint8_t jump;
+	// A-instruction constant.
+	uint16_t value;
+};
+
+/*
+* Translates Hack machine code into Instructions. The fused decode keeps
+* every address that falls in the middle of a superinstruction decoded on
+* its own, so a jump into the middle of an idiom still executes (and counts)
+* exactly the instructions that follow it.
+*/
+class Decoder
+{
+public:
+	// Decodes each ROM word as a single instruction (save for the halting idiom).
+	static std::vector<Instruction> Decode(const std::vector<uint16_t>& rom);
+	// Decodes each ROM word, fusing idioms that start there and stay within its basic block.
+	static std::vector<Instruction> Fuse(const std::vector<uint16_t>& rom);
+	// Marks first instruction of each basic block: jump targets and instructions following jumps.
+	static std::vector<bool> FindLeaders(const std::vector<uint16_t>& rom);
+private:
+	static Instruction DecodeWord(uint16_t word);
+	static bool IsCompute(uint16_t word) { return (word & 0x8000) != 0; }
+	static bool IsJump(uint16_t word) { return IsCompute(word) && (word & 0b111) != 0; }
+};
+} // namespace hack
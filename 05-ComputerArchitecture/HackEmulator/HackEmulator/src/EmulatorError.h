@@ -0,0 +1,18 @@
+#pragma once
+#include <exception>
+#include <string>
+
+namespace hack {
+class EmulatorError : public std::exception
+{
+public:
+	EmulatorError(const std::string message) :
+		msg_{ "EmulatorError: " + message } {}
+	virtual const char* what() const noexcept override
+	{
+		return msg_.c_str();
+	}
+protected:
+	std::string msg_;
+};
+} // namespace hack
@@ -0,0 +1,45 @@
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <filesystem>
+#include "FrameDumper.h"
+
+namespace hack {
+const std::string FrameDumper::s_HEADER = "P6\n" + std::to_string(Screen::WIDTH) + " " +
+	std::to_string(Screen::HEIGHT) + "\n255\n";
+
+// Pixels start out white, as does the screen of a freshly reset computer.
+FrameDumper::FrameDumper(const std::string& directory)
+	:m_Directory{ directory }, m_Pixels(Screen::WIDTH * Screen::HEIGHT * 3, 255)
+{
+	std::filesystem::create_directories(m_Directory);
+}
+
+bool FrameDumper::Capture(Computer& computer, uint64_t number)
+{
+	Screen& screen = computer.GetScreen();
+	if (!screen.IsDirty())
+		return false;
+	for (const Screen::Span& span : screen.DirtySpans())
+	{
+		for (int col = span.first; col <= span.last; col++)
+		{
+			uint16_t word = computer.Peek(Computer::SCREEN + span.row * Screen::WORDS_PER_ROW + col);
+			// Least significant bit is the leftmost pixel; 1 is black.
+			uint8_t* pixel = &m_Pixels[(span.row * Screen::WIDTH + col * 16) * 3];
+			for (int bit = 0; bit < 16; bit++, pixel += 3)
+				pixel[0] = pixel[1] = pixel[2] = ((word >> bit) & 1) ? 0 : 255;
+		}
+	}
+	screen.ClearDirty();
+	std::ostringstream name;
+	name << std::setw(6) << std::setfill('0') << number << ".ppm";
+	std::filesystem::path path = std::filesystem::path(m_Directory) / name.str();
+	std::ofstream ofs{ path, std::ios::binary };
+	if (!ofs)
+		throw std::ofstream::failure("Problem encountered while creating " + path.string());
+	ofs << s_HEADER;
+	ofs.write(reinterpret_cast<const char*>(m_Pixels.data()), m_Pixels.size());
+	return true;
+}
+} // namespace hack
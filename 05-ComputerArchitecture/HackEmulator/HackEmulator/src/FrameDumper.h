@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Computer.h"
+
+namespace hack {
+/*
+* Writes the emulated screen to numbered binary PPM images in a directory.
+* The dumper keeps its own copy of the frame and only converts the words
+* that changed since the previous capture, so recording every frame of a
+* program costs little more than writing the files themselves.
+*/
+class FrameDumper
+{
+public:
+	explicit FrameDumper(const std::string& directory);
+	/*
+	* Brings the frame up to date with the computer's screen and clears its
+	* dirty words. Writes the frame as number.ppm if anything changed, and
+	* returns whether it did.
+	*/
+	bool Capture(Computer& computer, uint64_t number);
+private:
+	std::string m_Directory;
+	// RGB pixels, row by row.
+	std::vector<uint8_t> m_Pixels;
+	// PPM header for a 512x256 image with 8-bit channels.
+	static const std::string s_HEADER;
+};
+} // namespace hack
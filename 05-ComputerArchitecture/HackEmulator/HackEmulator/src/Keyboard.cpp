@@ -0,0 +1,65 @@
+#include <fstream>
+#include <sstream>
+#include "Keyboard.h"
+#include "EmulatorError.h"
+
+namespace hack {
+Keyboard::Keyboard()
+	:m_Next{ 0 }
+{
+}
+
+void Keyboard::Load(const std::string& path)
+{
+	std::ifstream ifs{ path };
+	if (!ifs)
+		throw std::ifstream::failure("Problem encountered while opening \"" + path + "\"");
+	std::vector<Event> events;
+	std::string line;
+	for (int number = 1; std::getline(ifs, line); number++)
+	{
+		line = line.substr(0, line.find("//"));
+		if (line.find_first_not_of(" \t\r") == std::string::npos)
+			continue;
+		std::istringstream iss{ line };
+		std::string rest;
+		Event event;
+		if (!(iss >> event.cycle >> event.key) || (iss >> rest))
+			throw EmulatorError(path + ":" + std::to_string(number) + ": expected CYCLE KEY");
+		if (!events.empty() && event.cycle < events.back().cycle)
+			throw EmulatorError(path + ":" + std::to_string(number) + ": cycle " +
+				std::to_string(event.cycle) + " is before the previous event's");
+		events.push_back(event);
+	}
+	m_Events = events;
+	m_Next = 0;
+}
+
+void Keyboard::Save(const std::string& path) const
+{
+	std::ofstream ofs{ path };
+	if (!ofs)
+		throw std::ofstream::failure("Problem encountered while creating \"" + path + "\"");
+	ofs << "// CYCLE KEY" << std::endl;
+	for (const Event& event : m_Events)
+		ofs << event.cycle << " " << event.key << "\n";
+}
+
+void Keyboard::Record(uint64_t cycle, uint16_t key)
+{
+	m_Events.push_back({ cycle, key });
+	// The computer has already seen the key; it is not replayed.
+	m_Next = m_Events.size();
+}
+
+void Keyboard::Replay(Computer& computer)
+{
+	for (; m_Next < m_Events.size() && m_Events[m_Next].cycle <= computer.Cycles(); m_Next++)
+		computer.Poke(Computer::KBD, m_Events[m_Next].key);
+}
+
+uint64_t Keyboard::NextCycle() const
+{
+	return (m_Next < m_Events.size()) ? m_Events[m_Next].cycle : NEVER;
+}
+} // namespace hack
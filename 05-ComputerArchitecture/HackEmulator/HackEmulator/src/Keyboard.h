@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include "Computer.h"
+
+namespace hack {
+/*
+* A script of keyboard input keyed by clock cycle, so that a program which
+* polls the keyboard memory map sees the same keys on the same cycles on
+* every run. A script file holds one event per line:
+*
+*	CYCLE KEY
+*
+* meaning that from clock cycle CYCLE on, KBD reads KEY (a Hack key code;
+* 0 releases the key). Events are in non-decreasing cycle order; blank
+* lines and "//" comments are ignored.
+*/
+class Keyboard
+{
+public:
+	struct Event
+	{
+		uint64_t cycle;
+		uint16_t key;
+	};
+	// Cycle of the next event once the script is exhausted.
+	static const uint64_t NEVER = std::numeric_limits<uint64_t>::max();
+	// Hack key codes for keys that have no printable character.
+	static const uint16_t NEWLINE = 128;
+	static const uint16_t BACKSPACE = 129;
+	static const uint16_t LEFT_ARROW = 130;
+	static const uint16_t UP_ARROW = 131;
+	static const uint16_t RIGHT_ARROW = 132;
+	static const uint16_t DOWN_ARROW = 133;
+	static const uint16_t HOME = 134;
+	static const uint16_t END = 135;
+	static const uint16_t PAGE_UP = 136;
+	static const uint16_t PAGE_DOWN = 137;
+	static const uint16_t INSERT = 138;
+	static const uint16_t DEL = 139;
+	static const uint16_t ESC = 140;
+	static const uint16_t F1 = 141;		// F1..F12 are 141..152
+public:
+	Keyboard();
+	// Replaces the script with the one in the file at path, to be replayed from its start.
+	void Load(const std::string& path);
+	void Save(const std::string& path) const;
+	// Appends an event for a key already written to KBD, as when recording live input.
+	void Record(uint64_t cycle, uint16_t key);
+	// Writes to KBD every key not yet replayed whose cycle has been reached.
+	void Replay(Computer& computer);
+	// Cycle of the next event to replay, or NEVER.
+	uint64_t NextCycle() const;
+	const std::vector<Event>& Events() const { return m_Events; }
+private:
+	std::vector<Event> m_Events;
+	// Index of the next event to replay.
+	size_t m_Next;
+};
+} // namespace hack
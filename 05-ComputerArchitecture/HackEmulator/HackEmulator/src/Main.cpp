@@ -0,0 +1,214 @@
+#include <iostream>
+#include <string>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <algorithm>
+#include <thread>
+#include "Computer.h"
+#include "FrameDumper.h"
+#include "Keyboard.h"
+#include "Console.h"
+#include "Profiler.h"
+
+namespace fs = std::filesystem;
+
+const std::string g_SRC_EXT = ".hack";
+// While recording, the clock is held to this rate so that live play runs at a usable speed,
+const double g_LIVE_HZ = 1e6;
+// and the terminal is read at least this often.
+const uint64_t g_LIVE_POLL_CYCLES = 10000;
+
+void Usage(const std::string& programName);
+
+/*
+* Run a Hack machine code program on the emulated Hack computer.
+*
+* Input:	Hack machine code file (.hack extension) and options
+* Output:	Cycles executed, and optionally a range of RAM once stopped,
+*			screen frames and a script of the keys typed
+*/
+int main(int argc, char* argv[])
+{
+	const std::string program_name = fs::path(argv[0]).stem().string();
+	uint64_t max_cycles = std::numeric_limits<uint64_t>::max();
+	bool fuse = true;
+	bool translate = true;
+	int dump_from = 0, dump_to = -1;
+	std::string frame_dir;
+	uint64_t frame_cycles = 100000;
+	std::string replay_path, record_path;
+	uint64_t key_cycles = 100000;
+	std::string sym_path, folded_path, profile_path;
+	fs::path hack_path;
+	try
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			if (arg == "-c" && i + 1 < argc)
+				max_cycles = std::stoull(argv[++i]);
+			else if (arg == "-d" && i + 1 < argc)
+			{	// RAM range as FROM:TO, inclusive.
+				std::string range = argv[++i];
+				size_t colon = range.find(':');
+				dump_from = std::stoi(range.substr(0, colon));
+				dump_to = (colon == std::string::npos) ? dump_from : std::stoi(range.substr(colon + 1));
+			}
+			else if (arg == "-f" && i + 1 < argc)
+				frame_dir = argv[++i];
+			else if (arg == "--frame-cycles" && i + 1 < argc)
+				frame_cycles = std::max(1ull, std::stoull(argv[++i]));
+			else if (arg == "-k" && i + 1 < argc)
+				replay_path = argv[++i];
+			else if (arg == "-r" && i + 1 < argc)
+				record_path = argv[++i];
+			else if (arg == "--key-cycles" && i + 1 < argc)
+				key_cycles = std::max(1ull, std::stoull(argv[++i]));
+			else if (arg == "-p" && i + 1 < argc)
+				sym_path = argv[++i];
+			else if (arg == "--folded" && i + 1 < argc)
+				folded_path = argv[++i];
+			else if (arg == "--profile-out" && i + 1 < argc)
+				profile_path = argv[++i];
+			else if (arg == "--no-fusion")
+				fuse = false;
+			else if (arg == "--no-blocks")
+				translate = false;
+			else if (hack_path.empty() && fs::path(arg).extension() == g_SRC_EXT)
+				hack_path = arg;
+			else
+				throw std::invalid_argument(arg);
+		}
+	}
+	catch (const std::exception&)
+	{
+		Usage(program_name);
+		return EXIT_FAILURE;
+	}
+	if (hack_path.empty() || (!replay_path.empty() && !record_path.empty()) ||
+		((!folded_path.empty() || !profile_path.empty()) && sym_path.empty()))
+	{
+		Usage(program_name);
+		return EXIT_FAILURE;
+	}
+	try
+	{
+		hack::Computer computer;
+		computer.Load(hack_path.string(), fuse, translate);
+		std::unique_ptr<hack::FrameDumper> dumper;
+		if (!frame_dir.empty())
+			dumper = std::make_unique<hack::FrameDumper>(frame_dir);
+		hack::Keyboard keyboard;
+		if (!replay_path.empty())
+			keyboard.Load(replay_path);
+		std::unique_ptr<hack::Console> console;
+		if (!record_path.empty())
+			console = std::make_unique<hack::Console>();
+		std::unique_ptr<hack::Profiler> profiler;
+		if (!sym_path.empty())
+		{
+			profiler = std::make_unique<hack::Profiler>(sym_path);
+			computer.SetProfiler(profiler.get());
+		}
+		const uint64_t NEVER = hack::Keyboard::NEVER;
+		uint64_t next_frame = dumper ? frame_cycles : NEVER;
+		// Cycle at which a key typed live is let go, unless typed again by then.
+		uint64_t release = NEVER;
+		auto start = std::chrono::steady_clock::now();
+		// Run in slices that end on every keyboard event and frame boundary, so that
+		// each key reaches KBD on the same cycle whenever the script is replayed.
+		while (!computer.Halted() && computer.Cycles() < max_cycles)
+		{
+			uint64_t now = computer.Cycles();
+			keyboard.Replay(computer);
+			uint64_t stop = std::min({ max_cycles, next_frame, keyboard.NextCycle() });
+			if (console)
+			{
+				int key = console->ReadKey();
+				if (key == hack::Console::STOP)
+					break;
+				if (key != 0)
+				{
+					if (key != computer.Peek(hack::Computer::KBD))
+					{
+						computer.Poke(hack::Computer::KBD, key);
+						keyboard.Record(now, key);
+					}
+					release = now + key_cycles;
+				}
+				else if (release <= now)
+				{
+					computer.Poke(hack::Computer::KBD, 0);
+					keyboard.Record(now, 0);
+					release = NEVER;
+				}
+				stop = std::min({ stop, release, now + g_LIVE_POLL_CYCLES });
+			}
+			computer.Run(stop - now);
+			if (dumper && (computer.Cycles() >= next_frame || computer.Halted() || computer.Cycles() >= max_cycles))
+			{	// Frames in which nothing changed are skipped.
+				dumper->Capture(computer, next_frame / frame_cycles - 1);
+				next_frame += frame_cycles;
+			}
+			if (console)
+				std::this_thread::sleep_until(start + std::chrono::duration<double>(computer.Cycles() / g_LIVE_HZ));
+		}
+		if (!record_path.empty())
+			keyboard.Save(record_path);
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		std::cout << (computer.Halted() ? "Halted" : "Stopped") << " after ";
+		std::cout << computer.Cycles() << " cycles (" << elapsed.count() << " s)" << std::endl;
+		for (int address = dump_from; address <= dump_to; address++)
+			std::cout << "RAM[" << address << "] = " << computer.Peek(address) << std::endl;
+		if (profiler)
+		{
+			profiler->WriteFlat(std::cout);
+			if (!folded_path.empty())
+			{
+				std::ofstream ofs{ folded_path };
+				if (!ofs)
+					throw std::ofstream::failure("Problem encountered while creating \"" + folded_path + "\"");
+				profiler->WriteFolded(ofs);
+			}
+			if (!profile_path.empty())
+			{
+				std::ofstream ofs{ profile_path };
+				if (!ofs)
+					throw std::ofstream::failure("Problem encountered while creating \"" + profile_path + "\"");
+				profiler->WriteProfile(ofs);
+			}
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << hack_path.filename().string() << ": " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+/*
+* On invalid command-line arguments, gives user usage information.
+*/
+void Usage(const std::string& programName)
+{
+	std::cerr << "Usage: " << programName << " [OPTION]... FILE" << std::endl;
+	std::cerr << "Description: Run a Hack machine code file (.hack) on an emulated Hack computer." << std::endl;
+	std::cerr << "  -c CYCLES      Stop after CYCLES clock cycles (default: run until halted)" << std::endl;
+	std::cerr << "  -d FROM[:TO]   Print RAM[FROM..TO] once stopped" << std::endl;
+	std::cerr << "  -f DIR         Write the screen to DIR/NNNNNN.ppm for each frame in which it changed" << std::endl;
+	std::cerr << "  --frame-cycles N  Clock cycles per frame written with -f (default: 100000)" << std::endl;
+	std::cerr << "  -k FILE        Replay the keys in the script FILE (lines of \"CYCLE KEY\")" << std::endl;
+	std::cerr << "  -r FILE        Record keys typed on the terminal to the script FILE; Ctrl-C stops" << std::endl;
+	std::cerr << "  --key-cycles N    Clock cycles a key typed with -r stays down (default: 100000)" << std::endl;
+	std::cerr << "  -p FILE.sym    Profile cycles and calls per function, using the assembler's symbol map" << std::endl;
+	std::cerr << "  --folded FILE  With -p, also write the call stacks in folded form for flame graphs" << std::endl;
+	std::cerr << "  --profile-out FILE  With -p, also write the profile read by the compiler's and translator's --profile" << std::endl;
+	std::cerr << "  --no-fusion    Do not fuse instruction idioms into superinstructions" << std::endl;
+	std::cerr << "  --no-blocks    Interpret every instruction (no translation of hot blocks)";
+	std::cerr << std::endl;
+}
@@ -0,0 +1,187 @@
+#include <algorithm>		// std::sort
+#include <fstream>
+#include <iomanip>
+#include <numeric>			// std::iota
+#include <sstream>
+#include "Profiler.h"
+#include "EmulatorError.h"
+
+namespace hack {
+// RAM address of the stack pointer, and the words a VM call pushes before jumping.
+static const uint16_t SP = 0;
+static const uint16_t FRAME_SIZE = 5;
+
+const std::string Profiler::s_ROOT = "(bootstrap)";
+const std::string Profiler::s_HALT = "Sys.halt";
+
+Profiler::Profiler(const std::string& symPath)
+	:m_FunctionAt(Computer::MEMORY_SIZE, -1), m_Nodes{ { -1, 0, 0, 0, {} } }, m_Current{ 0 }
+{
+	std::ifstream ifs{ symPath };
+	if (!ifs)
+		throw std::ifstream::failure("Problem encountered while opening \"" + symPath + "\"");
+	std::string line;
+	for (int number = 1; std::getline(ifs, line); number++)
+	{
+		std::istringstream iss{ line };
+		size_t address;
+		std::string label;
+		if (!(iss >> address))
+			continue;
+		if (!(iss >> label) || address >= Computer::MEMORY_SIZE)
+			throw EmulatorError(symPath + ":" + std::to_string(number) + ": expected ADDRESS LABEL");
+		// Skip the translator's labels within functions, and return addresses.
+		if (label[0] == '_' || label.find('$') != std::string::npos)
+			continue;
+		m_FunctionAt[address] = static_cast<int>(m_Functions.size());
+		m_Functions.push_back(label);
+	}
+}
+
+void Profiler::Jump(const Computer& computer, uint16_t fallthrough, uint16_t target)
+{
+	if (!m_Stack.empty() && target == m_Stack.back().returnAddress)
+	{
+		m_Stack.pop_back();
+		m_Current = m_Stack.empty() ? 0 : m_Stack.back().node;
+		return;
+	}
+	int function = m_FunctionAt[target];
+	if (function < 0)
+		return;
+	// Unlike a goto to a label at the start of a function, a call leaves its return address on the stack.
+	uint16_t sp = computer.Peek(SP);
+	if (static_cast<uint16_t>(computer.Peek(sp - FRAME_SIZE)) != fallthrough)
+		return;
+	if (m_Stack.size() >= s_MAX_DEPTH)
+	{
+		m_Stack.push_back({ m_Current, fallthrough });
+		return;
+	}
+	auto it = m_Nodes[m_Current].children.find(function);
+	size_t callee;
+	if (it != m_Nodes[m_Current].children.end())
+		callee = it->second;
+	else
+	{
+		callee = m_Nodes.size();
+		m_Nodes[m_Current].children[function] = callee;
+		m_Nodes.push_back({ function, m_Current, 0, 0, {} });
+	}
+	m_Nodes[callee].calls++;
+	m_Stack.push_back({ callee, fallthrough });
+	m_Current = callee;
+}
+
+void Profiler::WriteFlat(std::ostream& os) const
+{
+	// Index m_Functions.size() stands for the root.
+	const size_t count = m_Functions.size() + 1;
+	std::vector<uint64_t> self(count, 0), inclusive(count, 0), calls(count, 0);
+	for (const Node& node : m_Nodes)
+	{
+		size_t f = node.function < 0 ? m_Functions.size() : node.function;
+		self[f] += node.cycles;
+		calls[f] += node.calls;
+	}
+	const uint64_t total = Total(inclusive);
+	std::vector<size_t> order(count);
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&self](size_t a, size_t b) { return self[a] > self[b]; });
+	os << "  %time   self cycles  total cycles       calls  function" << std::endl;
+	for (size_t f : order)
+	{
+		if (inclusive[f] == 0)
+			continue;
+		os << std::fixed << std::setprecision(2) << std::setw(7) << (total ? 100.0 * self[f] / total : 0.0);
+		os << std::setw(14) << self[f] << std::setw(14) << inclusive[f] << std::setw(12) << calls[f];
+		os << "  " << Name(f == m_Functions.size() ? -1 : static_cast<int>(f)) << "\n";
+	}
+	os.flush();
+}
+
+/*
+* A function's total counts each cycle once, even when it is on the stack
+* more than once. Runaway recursion can make the tree as deep as it is
+* large, so it is walked with a stack of its own rather than recursively.
+*/
+uint64_t Profiler::Total(std::vector<uint64_t>& inclusive) const
+{
+	std::vector<int> active(m_Functions.size() + 1, 0);
+	std::vector<Visit> stack{ { 0, m_Nodes[0].children.begin(), m_Nodes[0].cycles } };
+	active[m_Functions.size()]++;
+	for (;;)
+	{
+		Visit& visit = stack.back();
+		if (visit.next != m_Nodes[visit.node].children.end())
+		{
+			const size_t node = (visit.next++)->second;
+			const Node& n = m_Nodes[node];
+			active[n.function < 0 ? m_Functions.size() : n.function]++;
+			stack.push_back({ node, n.children.begin(), n.cycles });
+			continue;
+		}
+		const Node& n = m_Nodes[visit.node];
+		const size_t f = n.function < 0 ? m_Functions.size() : n.function;
+		const uint64_t total = visit.value;
+		if (--active[f] == 0)
+			inclusive[f] += total;
+		stack.pop_back();
+		if (stack.empty())
+			return total;
+		stack.back().value += total;
+	}
+}
+
+void Profiler::WriteProfile(std::ostream& os) const
+{
+	const size_t count = m_Functions.size() + 1;
+	std::vector<uint64_t> self(count, 0), calls(count, 0);
+	std::map<std::pair<int, int>, uint64_t> edges;
+	uint64_t total = 0;
+	for (const Node& node : m_Nodes)
+	{
+		size_t f = node.function < 0 ? m_Functions.size() : node.function;
+		self[f] += node.cycles;
+		calls[f] += node.calls;
+		if (Name(node.function) != s_HALT)
+			total += node.cycles;
+		if (node.function >= 0)
+			edges[{ m_Nodes[node.parent].function, node.function }] += node.calls;
+	}
+	os << "total " << total << "\n";
+	for (size_t f = 0; f < count; f++)
+		if (self[f] || calls[f])
+			os << "function " << Name(f == m_Functions.size() ? -1 : static_cast<int>(f)) << " " << calls[f] << " " << self[f] << "\n";
+	for (const auto& [edge, n] : edges)
+		os << "call " << Name(edge.first) << " " << Name(edge.second) << " " << n << "\n";
+	os.flush();
+}
+
+// Walks the call tree as Total does, growing and shrinking a single string of frames.
+void Profiler::WriteFolded(std::ostream& os) const
+{
+	std::string frames = Name(m_Nodes[0].function);
+	if (m_Nodes[0].cycles)
+		os << frames << " " << m_Nodes[0].cycles << "\n";
+	std::vector<Visit> stack{ { 0, m_Nodes[0].children.begin(), 0 } };
+	while (!stack.empty())
+	{
+		Visit& visit = stack.back();
+		if (visit.next == m_Nodes[visit.node].children.end())
+		{
+			frames.resize(visit.value);
+			stack.pop_back();
+			continue;
+		}
+		const size_t node = (visit.next++)->second;
+		const Node& n = m_Nodes[node];
+		const size_t length = frames.size();
+		frames += ";" + Name(n.function);
+		if (n.cycles)
+			os << frames << " " << n.cycles << "\n";
+		stack.push_back({ node, n.children.begin(), length });
+	}
+	os.flush();
+}
+} // namespace hack
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Computer.h"
+
+namespace hack {
+/*
+* Attributes every clock cycle of a run to the VM function executing it,
+* using the symbol map (.sym) written by the assembler with -s.
+*
+* Labels of VM functions are told apart from the translator's other labels,
+* which contain '$' or start with '_'. The profiler keeps a shadow call
+* stack: a call is a taken jump to a function label right after the
+* address following the jump has been pushed as the return address of a
+* new frame (at SP-5), and a return is a jump to the return address of a
+* frame on the shadow stack. Since only the last instruction of a fused
+* instruction or a block can jump, cycles are counted exactly in all modes.
+* The 2K words of the Hack stack hold a few hundred frames at most, so
+* past s_MAX_DEPTH calls, as in runaway recursion, the call tree stops
+* growing and the deeper calls' cycles go to the deepest function in it.
+*/
+class Profiler
+{
+public:
+	// Loads the function labels from a symbol map of "ADDRESS LABEL" lines.
+	explicit Profiler(const std::string& symPath);
+	/*
+	* Counts cycles just run by computer, whose last instruction ended at
+	* fallthrough and was followed by the one at target.
+	*/
+	void Count(const Computer& computer, uint32_t cycles, uint16_t fallthrough, uint16_t target)
+	{
+		m_Nodes[m_Current].cycles += cycles;
+		// The bootstrap's call to Sys.init may jump to the very next address.
+		if (target != fallthrough || m_FunctionAt[target] >= 0)
+			Jump(computer, fallthrough, target);
+	}
+	// Writes each function's cycles and calls, most expensive first.
+	void WriteFlat(std::ostream& os) const;
+	// Writes "caller;...;callee cycles" lines, the folded stacks read by flame graph tools.
+	void WriteFolded(std::ostream& os) const;
+	/*
+	* Writes the profile read back by the Jack compiler and the VM translator
+	* to optimize for it: the total cycles, then each function's calls and
+	* own cycles, then the number of calls from each caller to each callee.
+	* The total leaves out the cycles of Sys.halt, which loops forever once
+	* the program is done, so that they do not make all else look cold:
+	*
+	*	total CYCLES
+	*	function NAME CALLS CYCLES
+	*	call CALLER CALLEE CALLS
+	*/
+	void WriteProfile(std::ostream& os) const;
+private:
+	// A function in a particular call stack.
+	struct Node
+	{
+		int function;
+		size_t parent;
+		uint64_t cycles;
+		uint64_t calls;
+		std::map<int, size_t> children;
+	};
+	// A node of the call tree being walked, with its next child to visit.
+	struct Visit
+	{
+		size_t node;
+		std::map<int, size_t>::const_iterator next;
+		// Cycles of the subtree so far, or length of the folded stack above the node
+		uint64_t value;
+	};
+	struct Frame
+	{
+		// Node of the call tree running while the frame is on top
+		size_t node;
+		uint16_t returnAddress;
+	};
+	// Name of the root of the call tree, for code run before the first call.
+	static const std::string s_ROOT;
+	// The OS function that ends a program.
+	static const std::string s_HALT;
+	// Deepest call stack kept in the call tree
+	static const size_t s_MAX_DEPTH = 1024;
+
+	std::vector<std::string> m_Functions;
+	// Index of the function whose label is at each ROM address, or -1.
+	std::vector<int> m_FunctionAt;
+	// Call tree; node 0 is the root.
+	std::vector<Node> m_Nodes;
+	size_t m_Current;
+	std::vector<Frame> m_Stack;
+
+	void Jump(const Computer& computer, uint16_t fallthrough, uint16_t target);
+	const std::string& Name(int function) const { return function < 0 ? s_ROOT : m_Functions[function]; }
+	// Cycles spent in the whole call tree, adding each function's share to inclusive.
+	uint64_t Total(std::vector<uint64_t>& inclusive) const;
+};
+} // namespace hack
@@ -0,0 +1,42 @@
+#include <algorithm>		// std::fill, std::any_of
+#include <iterator>			// std::begin, std::end
+#include "Screen.h"
+
+namespace hack {
+Screen::Screen()
+{
+	ClearDirty();
+}
+
+bool Screen::IsDirty() const
+{
+	return std::any_of(std::begin(m_DirtyRows), std::end(m_DirtyRows),
+		[](uint32_t mask) { return mask != 0; });
+}
+
+std::vector<Screen::Span> Screen::DirtySpans() const
+{
+	std::vector<Span> spans;
+	for (int row = 0; row < HEIGHT; row++)
+	{
+		uint32_t mask = m_DirtyRows[row];
+		int col = 0;
+		while (mask != 0)
+		{
+			// Skip clean words, then take the run of dirty ones.
+			for (; (mask & 1) == 0; mask >>= 1)
+				col++;
+			int first = col;
+			for (; (mask & 1) != 0; mask >>= 1)
+				col++;
+			spans.push_back({ row, first, col - 1 });
+		}
+	}
+	return spans;
+}
+
+void Screen::ClearDirty()
+{
+	std::fill(std::begin(m_DirtyRows), std::end(m_DirtyRows), 0);
+}
+} // namespace hack
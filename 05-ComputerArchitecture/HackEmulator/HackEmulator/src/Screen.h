@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace hack {
+/*
+* Keeps track of which words of the screen memory map have changed, so
+* that anything drawing the 512x256 screen only needs to convert those.
+* Each of the 256 rows is 32 words wide, so one 32-bit mask per row is
+* the bitset of its dirty words.
+*/
+class Screen
+{
+public:
+	static const int WIDTH = 512;
+	static const int HEIGHT = 256;
+	static const int WORDS_PER_ROW = WIDTH / 16;
+	// Number of words in the screen memory map.
+	static const uint16_t WORDS = HEIGHT * WORDS_PER_ROW;
+
+	// A run of adjacent changed words [first, last] within a row.
+	struct Span
+	{
+		int row;
+		int first;
+		int last;
+	};
+public:
+	Screen();
+	// Records that the word at offset from the start of the screen map changed.
+	void MarkDirty(uint16_t offset) { m_DirtyRows[offset / WORDS_PER_ROW] |= 1u << (offset % WORDS_PER_ROW); }
+	bool IsDirty() const;
+	// Spans of words changed since the last call to ClearDirty(), from top to bottom.
+	std::vector<Span> DirtySpans() const;
+	void ClearDirty();
+private:
+	// Bit i of entry r is set if word i of row r changed.
+	uint32_t m_DirtyRows[HEIGHT];
+};
+} // namespace hack
@@ -0,0 +1,75 @@
+#include <cctype>
+#include "Assembler.h"
+#include "Code.h"
+#include "CommandError.h"
+
+namespace Hack {
+// Number of bits in each Hack machine word
+static const size_t g_WORD_SIZE = 16;
+static const int BASE_VAR_ADDRESS = 16;
+
+// Convert n to binary as a string that is g_WORD_SIZE long, or empty if n needs more bits
+static std::string toBinary(int n)
+{
+	std::string address(g_WORD_SIZE, '0');
+	for (size_t bit = g_WORD_SIZE; n > 0; n /= 2)
+	{
+		if (bit == 0)
+			return "";
+		address[--bit] = static_cast<char>('0' + n % 2);
+	}
+	return address;
+}
+
+void Assembler::Assemble(Parser& parser, std::ostream& os)
+{
+	// First pass to populate symbol table with labels
+	m_InstructionNo = 0;
+	while (parser.HasMoreCommands())
+	{
+		parser.Advance();
+		Parser::CType c_type = parser.CommandType();
+		if (c_type == Parser::CType::A_COMMAND || c_type == Parser::CType::C_COMMAND)
+			m_InstructionNo++;
+		else if (c_type == Parser::CType::L_COMMAND)
+			m_ST.AddLabel(parser.Symbol(), m_InstructionNo);
+	}
+	// Second pass to handle variables and translate file
+	parser.Restart();
+	m_InstructionNo = 0;
+	int next_var_address = BASE_VAR_ADDRESS;
+	std::string instruction;
+	while (parser.HasMoreCommands())
+	{
+		instruction = "";
+		parser.Advance();
+		Parser::CType c_type = parser.CommandType();
+		if (c_type == Parser::CType::A_COMMAND) {
+			std::string symbol = parser.Symbol();
+			int address;
+			if (!symbol.empty() && symbol.find_first_not_of("0123456789") == std::string::npos)
+				address = std::stoi(symbol);
+			else if (!symbol.empty() && !isdigit(static_cast<unsigned char>(symbol[0]))) {
+				if (!m_ST.Contains(symbol))
+					m_ST.AddEntry(symbol, next_var_address++);
+				address = m_ST.GetAddress(symbol);
+			}
+			else
+				throw CommandError();
+			instruction = toBinary(address);
+		}
+		else if (c_type == Parser::CType::C_COMMAND)
+			// All C commands have three leftmost 1 bits
+			instruction = "111" +
+				Code::Comp(parser.Comp()) +
+				Code::Dest(parser.Dest()) +
+				Code::Jump(parser.Jump());
+		else if (c_type == Parser::CType::L_COMMAND)
+			continue;
+		if (instruction.size() != g_WORD_SIZE)
+			throw CommandError();
+		os << instruction << '\n';
+		m_InstructionNo++;
+	}
+}
+} // namespace Hack
@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include <ostream>
+#include "Parser.h"
+#include "SymbolTable.h"
+
+namespace Hack {
+/*
+* Assembles the commands a Parser reads into Hack machine code, one 16-bit
+* binary word per line. A first pass gives each label the address of the
+* instruction after it, and a second one translates the instructions,
+* giving each new variable the next RAM address from 16 on.
+*/
+class Assembler
+{
+private:
+	SymbolTable m_ST;
+	size_t m_InstructionNo;
+public:
+	Assembler() :m_InstructionNo(0) {}
+	// Writes the machine code of parser's commands to os. Throws CommandError on an invalid command.
+	void Assemble(Parser& parser, std::ostream& os);
+	// The program's labels and variables
+	const SymbolTable& Symbols() const { return m_ST; }
+	// Number of the instruction being assembled, or of instructions written once done
+	size_t InstructionNo() const { return m_InstructionNo; }
+};
+} // namespace Hack
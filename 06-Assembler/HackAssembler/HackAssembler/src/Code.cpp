@@ -41,7 +41,11 @@ const std::unordered_map<std::string, std::string> Code::s_CompMap = {
 	{"D-A", "010011"},
 	{"A-D", "000111"},
 	{"D&A", "000000"},
-	{"D|A", "010101"}
+	{"D|A", "010101"},
+	// Commutative computations with swapped operands, as in "A=M+D".
+	{"A+D", "000010"},
+	{"A&D", "000000"},
+	{"A|D", "010101"}
 };
 
 // Return the 3-bit binary code for dest, or "" if no match.
@@ -1,11 +1,15 @@
 #include "Parser.h"
 #include <sstream>
+#include <algorithm>
+#include <limits>
 #include <iostream>
 
+namespace Hack {
 Parser::Parser(const std::string& name)
+	:m_Ifs{ m_File }
 {
-	m_Ifs.open(name);
-	if (!m_Ifs)
+	m_File.open(name);
+	if (!m_File)
 	{
 		std::stringstream ss;
 		ss << "Failed to open: " << name;
@@ -13,9 +17,15 @@ Parser::Parser(const std::string& name)
 	}
 }
 
+Parser::Parser(std::istream& is)
+	:m_Ifs{ is }
+{
+}
+
 Parser::~Parser()
 {
-	m_Ifs.close();
+	if (m_File.is_open())
+		m_File.close();
 }
 
 void Parser::Restart()
@@ -50,12 +60,11 @@ bool Parser::HasMoreCommands()
 void Parser::Advance()
 {
 	std::getline(m_Ifs, m_CurrentCommand);
-	std::stringstream iss{ m_CurrentCommand };
-	std::stringstream oss;
-	char c;
-	while (iss >> c && c != '/')
-		oss << c;
-	oss >> m_CurrentCommand; // HasMoreCommands takes care of trailing spaces.
+	const size_t comment = m_CurrentCommand.find('/');
+	if (comment != std::string::npos)
+		m_CurrentCommand.erase(comment);
+	m_CurrentCommand.erase(std::remove_if(m_CurrentCommand.begin(), m_CurrentCommand.end(),
+		[](unsigned char c) { return isspace(c); }), m_CurrentCommand.end());
 }
 
 /* 
@@ -132,4 +141,5 @@ std::string Parser::Jump() const
 {
 	size_t offset = m_CurrentCommand.find(';');
 	return (offset != std::string::npos) ? m_CurrentCommand.substr(offset + 1) : "";
-}
\ No newline at end of file
+}
+} // namespace Hack
@@ -1,20 +1,24 @@
 #pragma once
 #include <string>
 #include <fstream>
+#include <istream>
 
+namespace Hack {
 /*
-* Reads Hack assembly source file and parses its mnemonics.
-* Ignores white space and comments.
+* Reads Hack assembly source file, or a stream it is given, and parses
+* its mnemonics. Ignores white space and comments.
 */
 class Parser 
 {
 private:
-	// File stream for input Hack assembly source file
-	std::ifstream m_Ifs;
+	// File stream for input Hack assembly source file, if not reading a given stream
+	std::ifstream m_File;
+	std::istream& m_Ifs;
 	std::string m_CurrentCommand;
 public:
 	enum class CType { A_COMMAND, C_COMMAND, L_COMMAND, NO_COMMAND };
 	explicit Parser(const std::string& name);
+	explicit Parser(std::istream& is);
 	~Parser();
 
 	// Checks if there are more Hack commands
@@ -34,4 +38,4 @@ public:
 	std::string Comp() const;
 	std::string Jump() const;
 };
-
+} // namespace Hack
@@ -22,6 +22,12 @@ void SymbolTable::AddEntry(const std::string& symbol, int address)
 	m_ST.insert({ symbol, address });
 }
 
+void SymbolTable::AddLabel(const std::string& label, int address)
+{
+	AddEntry(label, address);
+	m_Labels.push_back({ address, label });
+}
+
 bool SymbolTable::Contains(const std::string& symbol) const
 {
 	return m_ST.find(symbol) != m_ST.end();
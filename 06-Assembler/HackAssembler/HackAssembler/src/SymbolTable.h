@@ -1,6 +1,8 @@
 #pragma once
 #include <unordered_map>
 #include <string>
+#include <vector>
+#include <utility>
 
 /*
 * Keeps correspondence between symbolic labls and numeric addresses
@@ -9,9 +11,14 @@ class SymbolTable
 {
 private:
 	std::unordered_map<std::string, int> m_ST;
+	// (ROM address, label) pairs in the order the labels were added
+	std::vector<std::pair<int, std::string>> m_Labels;
 public:
 	SymbolTable();
 	void AddEntry(const std::string& symbol, int address);
+	// Adds a label for a ROM address, also keeping it for the symbol map
+	void AddLabel(const std::string& label, int address);
+	const std::vector<std::pair<int, std::string>>& Labels() const { return m_Labels; }
 	bool Contains(const std::string& symbol) const;
 	int GetAddress(const std::string& symbol) const;
 };
\ No newline at end of file
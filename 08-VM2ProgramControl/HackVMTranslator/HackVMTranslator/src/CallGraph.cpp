@@ -0,0 +1,114 @@
+#include <algorithm>
+#include "CallGraph.h"
+
+const int CallGraph::s_VARIABLE_WORDS = 240;
+
+int CallGraph::Index(const std::string& functionName)
+{
+	auto [it, added] = m_Index.emplace(functionName, static_cast<int>(m_Functions.size()));
+	if (added)
+	{
+		m_Functions.emplace_back();
+		m_Names.push_back(functionName);
+	}
+	return it->second;
+}
+
+void CallGraph::AddStatic(const std::string& segment, int index)
+{
+	if (segment == "static")
+		m_Statics.insert(m_CurrentFile + "." + std::to_string(index));
+}
+
+void CallGraph::AddCommand(const std::string& command, const std::string& arg1, int arg2,
+	const std::string& arg3, int arg4)
+{
+	if (command == "function")
+	{
+		m_CurrentFunction = Index(arg1);
+		m_Functions[m_CurrentFunction].numLocals = arg2;
+	}
+	else if (command == "call" && m_CurrentFunction >= 0)
+	{
+		const int callee = Index(arg1);
+		m_Functions[m_CurrentFunction].callees.push_back(callee);
+	}
+	else if (command == "move")
+	{
+		AddStatic(arg1, arg2);
+		AddStatic(arg3, arg4);
+	}
+	else if (command == "push" || command == "pop" || command == "inc" || command == "dec" ||
+		command == "push-add" || command == "push-sub")
+		AddStatic(arg1, arg2);
+}
+
+/*
+* Tarjan's algorithm finds the strongly connected components of the graph,
+* the sets of functions that can all call each other, and finishes each
+* one after all those it can call. So frames are laid out from the
+* functions that call nothing up, each starting where the highest frame
+* of its callees ends. Functions of a component with more than one
+* function, or that calls itself, are recursive and are passed through.
+*/
+void CallGraph::Visit(Search& search, int f) const
+{
+	search.order[f] = search.low[f] = search.count++;
+	search.stack.push_back(f);
+	search.onStack[f] = true;
+	for (int callee : m_Functions[f].callees)
+	{
+		if (search.order[callee] < 0)
+		{
+			Visit(search, callee);
+			search.low[f] = std::min(search.low[f], search.low[callee]);
+		}
+		else if (search.onStack[callee])
+			search.low[f] = std::min(search.low[f], search.order[callee]);
+	}
+	if (search.low[f] != search.order[f])
+		return;
+	const int c = static_cast<int>(search.frameEnd.size());
+	std::vector<int> members;
+	int g;
+	do
+	{
+		g = search.stack.back();
+		search.stack.pop_back();
+		search.onStack[g] = false;
+		search.component[g] = c;
+		members.push_back(g);
+	} while (g != f);
+	int start = 0;
+	bool recursive = members.size() > 1;
+	for (int member : members)
+		for (int callee : m_Functions[member].callees)
+		{
+			if (search.component[callee] == c)
+				recursive = true;
+			else
+				start = std::max(start, search.frameEnd[search.component[callee]]);
+		}
+	const int num_locals = m_Functions[f].numLocals;
+	if (!recursive && num_locals > 0 && start + num_locals <= search.budget)
+	{
+		search.frames[m_Names[f]] = start;
+		start += num_locals;
+	}
+	search.frameEnd.push_back(start);
+}
+
+std::unordered_map<std::string, int> CallGraph::StaticFrames() const
+{
+	const size_t n = m_Functions.size();
+	Search search;
+	search.order.assign(n, -1);
+	search.low.assign(n, 0);
+	search.component.assign(n, -1);
+	search.onStack.assign(n, false);
+	search.budget = s_VARIABLE_WORDS - static_cast<int>(m_Statics.size());
+	for (size_t f = 0; f < n; f++)
+		if (search.order[f] < 0)
+			Visit(search, static_cast<int>(f));
+	return search.frames;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/*
+* The CallGraph is built from all the VM commands of a program, before
+* they are translated, to find the functions that can be given static
+* frames: their locals live at fixed RAM addresses, the assembler's
+* variables $frame.0, $frame.1, ..., instead of on the stack.
+*
+* A function can only have a static frame if it is never active twice at
+* once, that is if it cannot call itself through any chain of calls. Two
+* such functions may share slots as long as neither can call the other,
+* since then they are never active at the same time; so a function's
+* frame is laid out just above the frames of every function it may call.
+* Slots share RAM 16-255 with the program's static variables, and a
+* function whose frame would not fit there keeps its locals on the stack.
+*/
+class CallGraph
+{
+private:
+	// Number of RAM words the assembler has for variables, from 16 to 255
+	static const int s_VARIABLE_WORDS;
+	struct Function
+	{
+		int numLocals = 0;
+		// Indices of the functions it calls
+		std::vector<int> callees;
+	};
+	std::vector<Function> m_Functions;
+	std::unordered_map<std::string, int> m_Index;
+	std::vector<std::string> m_Names;
+	// Static variables used by the program, as the assembler names them
+	std::unordered_set<std::string> m_Statics;
+	// Name of VM file and function the commands being added are in
+	std::string m_CurrentFile;
+	int m_CurrentFunction;
+
+	// State of the search for strongly connected components, and the frames laid out
+	struct Search
+	{
+		std::vector<int> order, low, component, stack;
+		std::vector<bool> onStack;
+		int count = 0;
+		int budget;
+		// Slot just above the frames of each component, by component number
+		std::vector<int> frameEnd;
+		std::unordered_map<std::string, int> frames;
+	};
+
+	int Index(const std::string& functionName);
+	void AddStatic(const std::string& segment, int index);
+	// Visits function f and all it may call, laying out the frames of their components
+	void Visit(Search& search, int f) const;
+public:
+	CallGraph() :m_CurrentFunction(-1) {}
+	// Gets ready to add the commands of new VM file
+	void SetFileName(const std::string& name) { m_CurrentFile = name; }
+	// Adds a command with its arguments, as the Parser reads them
+	void AddCommand(const std::string& command, const std::string& arg1, int arg2,
+		const std::string& arg3 = "", int arg4 = 0);
+	// First slot of each function given a static frame
+	std::unordered_map<std::string, int> StaticFrames() const;
+};
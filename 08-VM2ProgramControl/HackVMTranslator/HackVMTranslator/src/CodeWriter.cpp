@@ -1,6 +1,9 @@
+#include <algorithm>
 #include <sstream>
+#include <vector>
 #include "CodeWriter.h"
 #include "InvalidCommand.h"
+#include "Parser.h"
 
 const std::unordered_map<std::string, std::string> CodeWriter::s_CmdMap = {
 	{"add", "+"},
@@ -25,11 +28,44 @@ const std::unordered_map<std::string, std::string> CodeWriter::s_SgmtMap = {
 	{"static", "static"}
 };
 
+// Extended VM commands that compare the top two values and jump on the result.
+const std::unordered_map<std::string, std::string> CodeWriter::s_IfCompareMap = {
+	{"if-eq", "JEQ"},
+	{"if-ne", "JNE"},
+	{"if-lt", "JLT"},
+	{"if-gt", "JGT"},
+	{"if-le", "JLE"},
+	{"if-ge", "JGE"}
+};
+
+void CodeWriter::InstructionCounter::Count(char c)
+{
+	if (m_LineStart && c != '(' && c != '\n')
+		m_Count++;
+	m_LineStart = (c == '\n');
+}
+
+CodeWriter::InstructionCounter::int_type CodeWriter::InstructionCounter::overflow(int_type c)
+{
+	if (traits_type::eq_int_type(c, traits_type::eof()))
+		return traits_type::not_eof(c);
+	Count(traits_type::to_char_type(c));
+	return m_Out ? m_Out->sputc(traits_type::to_char_type(c)) : c;
+}
+
+std::streamsize CodeWriter::InstructionCounter::xsputn(const char* s, std::streamsize n)
+{
+	for (std::streamsize i = 0; i < n; i++)
+		Count(s[i]);
+	return m_Out ? m_Out->sputn(s, n) : n;
+}
+
 CodeWriter::CodeWriter(const std::string& name):
-	m_LabelCount(0)
+	m_Counter(m_File.rdbuf()), m_Ofs(&m_Counter), m_LabelCount(0), m_Outline(false), m_CountedWords(0),
+	m_ReturnRoutine(false), m_FrameSlot(-1)
 {
-	m_Ofs.open(name + g_TARGET_EXT);
-	if (!m_Ofs)
+	m_File.open(name + g_TARGET_EXT);
+	if (!m_File)
 	{
 		std::stringstream ss;
 		ss << "Problem encountered while creating " << name;
@@ -37,17 +73,125 @@ CodeWriter::CodeWriter(const std::string& name):
 	}
 }
 
+CodeWriter::CodeWriter(std::ostream& os):
+	m_Counter(os.rdbuf()), m_Ofs(&m_Counter), m_LabelCount(0), m_Outline(false), m_CountedWords(0),
+	m_ReturnRoutine(false), m_FrameSlot(-1)
+{
+}
+
 CodeWriter::~CodeWriter()
 {
-	if (m_Ofs.is_open())
-		m_Ofs.close();
+	if (m_File.is_open())
+		m_File.close();
 }
 
 void CodeWriter::SetFileName(const std::string& name)
 {
 
 	m_CurrentFile = name;
-	m_LabelCount = 0;		// Reset label count for new file
+	// Label count is not reset, so return labels in Sys.init stay distinct from the bootstrap call's.
+}
+
+/*
+* Of the profile's lines, only each function's own cycles matter here;
+* functions it does not list never ran, and stay cold.
+*/
+void CodeWriter::LoadProfile(const std::string& path)
+{
+	std::ifstream ifs{ path };
+	if (!ifs)
+		throw std::ifstream::failure("Problem encountered while opening \"" + path + "\"");
+	std::string line;
+	while (std::getline(ifs, line))
+	{
+		std::istringstream iss{ line };
+		std::string kind, name;
+		uint64_t calls, self;
+		iss >> kind;
+		if (kind == "function" && iss >> name >> calls >> self)
+			m_Cycles[name] += self;
+	}
+	m_Outline = true;
+	m_HotFunctions.clear();
+}
+
+/*
+* A greedy choice: each function, in order of cycles per word its inline
+* code adds, is made hot if it still fits in the words of ROM that the
+* all-cold program leaves free. Making a function hot never makes another
+* one bigger, so the words each adds do not depend on the others chosen.
+*/
+void CodeWriter::ChooseHotFunctions(const CodeWriter& cold, const CodeWriter& hot)
+{
+	struct Candidate
+	{
+		std::string name;
+		uint64_t cycles;
+		size_t words;
+	};
+	std::vector<Candidate> candidates;
+	for (const auto& [name, cold_words] : cold.m_FunctionWords)
+	{
+		auto cycles = m_Cycles.find(name);
+		auto hot_words = hot.m_FunctionWords.find(name);
+		if (cycles == m_Cycles.end() || cycles->second == 0 || hot_words == hot.m_FunctionWords.end())
+			continue;
+		candidates.push_back({ name, cycles->second,
+			hot_words->second > cold_words ? hot_words->second - cold_words : 0 });
+	}
+	// Most cycles per word first; names break ties, so that the choice does not depend on hashing.
+	std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+		if (a.cycles * b.words != b.cycles * a.words)
+			return a.cycles * b.words > b.cycles * a.words;
+		return a.name < b.name;
+	});
+	size_t free_words = cold.Words() < ROM_WORDS ? ROM_WORDS - cold.Words() : 0;
+	m_HotFunctions.clear();
+	for (const Candidate& candidate : candidates)
+		if (candidate.words <= free_words)
+		{
+			m_HotFunctions.insert(candidate.name);
+			free_words -= candidate.words;
+		}
+}
+
+void CodeWriter::CountFunctionWords()
+{
+	m_FunctionWords[m_CurrentFunction] += Words() - m_CountedWords;
+	m_CountedWords = Words();
+}
+
+void CodeWriter::WriteCommand(const Parser& parser)
+{
+	HackVM::CType ctype = parser.CommandType();
+	if (ctype == HackVM::CType::C_ARITHMETIC)
+		WriteArithmetic(parser.Arg1());
+	else if (ctype == HackVM::CType::C_PUSH)
+		WritePushPop("push", parser.Arg1(), parser.Arg2());
+	else if (ctype == HackVM::CType::C_POP)
+		WritePushPop("pop", parser.Arg1(), parser.Arg2());
+	else if (ctype == HackVM::CType::C_LABEL)
+		WriteLabel(parser.Arg1());
+	else if (ctype == HackVM::CType::C_GOTO)
+		WriteGoto(parser.Arg1());
+	else if (ctype == HackVM::CType::C_IF)
+		WriteIf(parser.Arg1());
+	else if (ctype == HackVM::CType::C_IF_COMPARE)
+		WriteIfCompare(parser.Command(), parser.Arg1());
+	else if (ctype == HackVM::CType::C_INC)
+		WriteIncDec(parser.Command(), parser.Arg1(), parser.Arg2());
+	else if (ctype == HackVM::CType::C_MOVE)
+		WriteMove(parser.Arg1(), parser.Arg2(), parser.Arg3(), parser.Arg4());
+	else if (ctype == HackVM::CType::C_PUSH_OP)
+		WritePushOp(parser.Command(), parser.Arg1(), parser.Arg2());
+	else if (ctype == HackVM::CType::C_CALL)
+		WriteCall(parser.Arg1(), parser.Arg2());
+	else if (ctype == HackVM::CType::C_RETURN)
+		WriteReturn();
+	else if (ctype == HackVM::CType::C_FUNCTION)
+		WriteFunction(parser.Arg1(), parser.Arg2());
+	else
+		throw HackVM::InvalidCommand(m_CurrentFile + g_SRC_EXT);
 }
 
 /* 
@@ -58,7 +202,10 @@ void CodeWriter::SetFileName(const std::string& name)
 void CodeWriter::WriteInit()
 {
 	m_Ofs << "@256\nD=A\n@SP\nM=D\n";
+	// The call is counted with Sys.init, as it is inline only if Sys.init is hot
+	CountFunctionWords();
 	m_CurrentFunction = "Sys.init";
+	m_FrameSlot = -1;
 	WriteCall(m_CurrentFunction, 0);
 }
 
@@ -76,6 +223,13 @@ void CodeWriter::WriteArithmetic(const std::string& command)
 		// Replace next value by resultant of operation
 		m_Ofs << "A=M\nM=M" << it->second << "D\n@SP\nM=M+1\n";
 	}
+	else if ((command == "eq" || command == "lt" || command == "gt") && IsCold())
+	{
+		// Have the shared routine push the result and come back here
+		m_Ofs << "@_" << ++m_LabelCount << UniqueLabel("COMPARED") << "\nD=A\n@$" << command << "\n0;JMP\n";
+		m_Ofs << "(_" << m_LabelCount << UniqueLabel("COMPARED") << ")\n";
+		m_CompareRoutines.insert(command);
+	}
 	else if (command == "eq" || command == "lt" || command == "gt")
 	{
 		// Pop top two values and take their difference.
@@ -107,6 +261,8 @@ void CodeWriter::WritePushPop(const std::string& command, const std::string& seg
 		// Save value of static variable
 		if (segment == "static")
 			m_Ofs << "@" << m_CurrentFile << "." << index << "\nD=M\n";
+		else if (IsStaticLocal(segment))
+			m_Ofs << "@" << FrameSlot(index) << "\nD=M\n";
 		else
 		{
 			// Push the index value (if constant) or use as segment offset
@@ -131,6 +287,11 @@ void CodeWriter::WritePushPop(const std::string& command, const std::string& seg
 			m_Ofs << "@" << m_CurrentFile << "." << index << "\nM=D\n";
 			return;
 		}
+		else if (IsStaticLocal(segment))
+		{
+			m_Ofs << "@SP\nM=M-1\nA=M\nD=M\n@" << FrameSlot(index) << "\nM=D\n";
+			return;
+		}
 		// Calculate base segment address + offset
 		m_Ofs << "@" << index << "\nD=A\n@" << it->second << "\n";
 		if (segment == "local" || segment == "argument" || segment == "this" ||
@@ -174,11 +335,140 @@ void CodeWriter::WriteIf(const std::string& label)
 	m_Ofs << "@" << UniqueLabel(label) << "\nD;JNE\n";		// Jump if it's nonzero
 }
 
+/*
+* Writes commands that pop y and x and jump to a label if x compares to y
+* as the command says. Like lt and gt, it compares by the sign of x - y,
+* so "if-lt L" jumps exactly when "lt" followed by "if-goto L" would, in
+* a single D;Jxx and without pushing the boolean.
+*/
+void CodeWriter::WriteIfCompare(const std::string& command, const std::string& label)
+{
+	auto it = s_IfCompareMap.find(command);
+	if (it == s_IfCompareMap.end())
+		throw HackVM::InvalidCommand(m_CurrentFile + g_SRC_EXT);
+	// Pop top two values and take their difference.
+	m_Ofs << "@SP\nM=M-1\nA=M\nD=M\n@SP\nM=M-1\nA=M\nD=M-D\n";
+	m_Ofs << "@" << UniqueLabel(label) << "\nD;" << it->second << "\n";
+}
+
+bool CodeWriter::AddressUsesD(const std::string& segment, int index) const
+{
+	return index > 3 && !IsStaticLocal(segment) && (segment == "local" || segment == "argument" || segment == "this" || segment == "that");
+}
+
+/*
+* Addresses of static, pointer, temp and locals in a static frame are
+* known to the assembler, and a base segment's first few entries are
+* reached by incrementing A, so only the other entries of a base segment
+* need D for their offset.
+*/
+void CodeWriter::WriteAddress(const std::string& segment, int index)
+{
+	auto it = s_SgmtMap.find(segment);
+	if (it == s_SgmtMap.end() || segment == "constant")
+		throw HackVM::InvalidCommand(m_CurrentFile + g_SRC_EXT);
+	if (segment == "static")
+		m_Ofs << "@" << m_CurrentFile << "." << index << "\n";
+	else if (segment == "temp")
+		m_Ofs << "@" << 5 + index << "\n";
+	else if (segment == "pointer")
+		m_Ofs << "@" << 3 + index << "\n";
+	else if (IsStaticLocal(segment))
+		m_Ofs << "@" << FrameSlot(index) << "\n";
+	else if (AddressUsesD(segment, index))
+		m_Ofs << "@" << index << "\nD=A\n@" << it->second << "\nA=M+D\n";
+	else
+	{
+		m_Ofs << "@" << it->second << "\n" << (index == 0 ? "A=M" : "A=M+1") << "\n";
+		for (int i = 1; i < index; i++)
+			m_Ofs << "A=A+1\n";
+	}
+}
+
+void CodeWriter::WriteLoad(const std::string& segment, int index)
+{
+	if (segment == "constant")
+		m_Ofs << "@" << index << "\nD=A\n";
+	else
+	{
+		WriteAddress(segment, index);
+		m_Ofs << "D=M\n";
+	}
+}
+
+/*
+* Writes commands that add 1 to (inc) or subtract 1 from (dec) segment
+* index in place; extended VM only.
+*/
+void CodeWriter::WriteIncDec(const std::string& command, const std::string& segment, int index)
+{
+	if (command != "inc" && command != "dec")
+		throw HackVM::InvalidCommand(m_CurrentFile + g_SRC_EXT);
+	WriteAddress(segment, index);
+	m_Ofs << (command == "inc" ? "M=M+1\n" : "M=M-1\n");
+}
+
+/*
+* Writes commands that copy srcSegment srcIndex to dstSegment dstIndex,
+* like a push and a pop but without the stack; extended VM only. 0 and 1
+* are stored directly. Otherwise the value is carried in D, so a
+* destination whose address needs D has it computed first and kept in R13.
+*/
+void CodeWriter::WriteMove(const std::string& srcSegment, int srcIndex, const std::string& dstSegment, int dstIndex)
+{
+	if (srcSegment == "constant" && (srcIndex == 0 || srcIndex == 1))
+	{
+		WriteAddress(dstSegment, dstIndex);
+		m_Ofs << "M=" << srcIndex << "\n";
+	}
+	else if (AddressUsesD(dstSegment, dstIndex))
+	{
+		m_Ofs << "@" << dstIndex << "\nD=A\n@" << s_SgmtMap.at(dstSegment) << "\nD=M+D\n@R13\nM=D\n";
+		WriteLoad(srcSegment, srcIndex);
+		m_Ofs << "@R13\nA=M\nM=D\n";
+	}
+	else
+	{
+		WriteLoad(srcSegment, srcIndex);
+		WriteAddress(dstSegment, dstIndex);
+		m_Ofs << "M=D\n";
+	}
+}
+
+/*
+* Writes commands that add segment index to (push-add), or subtract it
+* from (push-sub), the value on top of the stack in place, as a push
+* followed by add or sub would; extended VM only.
+*/
+void CodeWriter::WritePushOp(const std::string& command, const std::string& segment, int index)
+{
+	if (command != "push-add" && command != "push-sub")
+		throw HackVM::InvalidCommand(m_CurrentFile + g_SRC_EXT);
+	const char op = (command == "push-add") ? '+' : '-';
+	if (segment == "constant" && index == 1)
+	{
+		m_Ofs << "@SP\nA=M-1\nM=M" << op << "1\n";
+		return;
+	}
+	WriteLoad(segment, index);
+	m_Ofs << "@SP\nA=M-1\nM=M" << op << "D\n";
+}
+
 /*
 * Writes commands that effect a function call.
 */
 void CodeWriter::WriteCall(const std::string& functionName, int numArgs)
 {
+	if (IsCold())
+	{
+		// The shared routine pushes the frame and comes back to jump to the function from here,
+		// so that the return address is still right after the jump.
+		m_Ofs << "@_" << ++m_LabelCount << UniqueLabel("CALL") << "\nD=A\n@$CALL." << numArgs << "\n0;JMP\n";
+		m_Ofs << "(_" << m_LabelCount << UniqueLabel("CALL") << ")\n@" << functionName << "\n0;JMP\n";
+		m_Ofs << "(_" << m_LabelCount << UniqueLabel("RETURN") << ")\n";
+		m_CallRoutines.insert(numArgs);
+		return;
+	}
 	// Temporarily save (push) return address (prepend integer for label uniqueness)
 	m_Ofs << "@_" << ++m_LabelCount << UniqueLabel("RETURN") << "\n";
 	m_Ofs << "D=A\n@SP\nA=M\nM=D\n@SP\nM=M+1\n";
@@ -205,6 +495,17 @@ void CodeWriter::WriteCall(const std::string& functionName, int numArgs)
 * Writes commands to effect returning from a called function to the caller.
 */
 void CodeWriter::WriteReturn()
+{
+	if (IsCold())
+	{
+		m_Ofs << "@$RETURN\n0;JMP\n";
+		m_ReturnRoutine = true;
+	}
+	else
+		WriteReturnCode();
+}
+
+void CodeWriter::WriteReturnCode()
 {
 	// Temporarily store top of caller's stack frame: FRAME=LCL
 	m_Ofs << "@LCL\nD=M\n@R13\nM=D\n";
@@ -228,12 +529,57 @@ void CodeWriter::WriteReturn()
 }
 
 /* 
-* Writes commands that create a label for a function and intializes locals to 0.
+* Writes commands that create a label for a function and intializes locals to 0,
+* on the stack or in its static frame.
 */
 void CodeWriter::WriteFunction(const std::string& functionName, int numLocals)
 {
+	CountFunctionWords();
 	m_CurrentFunction = functionName;
+	auto it = m_StaticFrames.find(functionName);
+	m_FrameSlot = (it == m_StaticFrames.end()) ? -1 : it->second;
 	m_Ofs << "(" << m_CurrentFunction << ")\n";
+	if (m_FrameSlot >= 0)
+	{
+		for (int i = 0; i < numLocals; i++)
+			m_Ofs << "@" << FrameSlot(i) << "\nM=0\n";
+		return;
+	}
 	while (numLocals--)
 		m_Ofs << "@SP\nA=M\nM=0\n@SP\nM=M+1\n";
-}
\ No newline at end of file
+}
+
+/*
+* Writes the routines jumped to by the call, return, eq, gt and lt
+* commands of cold functions, each only if it was used. A call routine
+* takes in D the address of the caller's jump to the function, which is
+* followed by the return address; a compare routine takes the address to
+* go back to. Both keep it in R13, which the inline code only uses within
+* a single command. The return routine is the inline return code.
+*/
+void CodeWriter::WriteRoutines()
+{
+	CountFunctionWords();
+	for (int numArgs : m_CallRoutines)
+	{
+		m_Ofs << "($CALL." << numArgs << ")\n@R13\nM=D\nD=D+1\nD=D+1\n";
+		m_Ofs << "@SP\nA=M\nM=D\n@SP\nM=M+1\n";
+		for (const char* sgmt : { "@LCL", "@ARG", "@THIS", "@THAT" })
+			m_Ofs << sgmt << "\nD=M\n@SP\nA=M\nM=D\n@SP\nM=M+1\n";
+		m_Ofs << "@SP\nD=M\n@" << numArgs << "\nD=D-A\n@5\nD=D-A\n@ARG\nM=D\n";
+		m_Ofs << "@SP\nD=M\n@LCL\nM=D\n@R13\nA=M\n0;JMP\n";
+	}
+	if (m_ReturnRoutine)
+	{
+		m_Ofs << "($RETURN)\n";
+		WriteReturnCode();
+	}
+	for (const std::string& command : m_CompareRoutines)
+	{
+		// Replace x by whether it compares to y as the command says
+		m_Ofs << "($" << command << ")\n@R13\nM=D\n@SP\nAM=M-1\nD=M\n@SP\nA=M-1\nD=M-D\n";
+		m_Ofs << "@$" << command << ".TRUE\nD;" << s_CmdMap.at(command) << "\n";
+		m_Ofs << "@SP\nA=M-1\nM=0\n@R13\nA=M\n0;JMP\n";
+		m_Ofs << "($" << command << ".TRUE)\n@SP\nA=M-1\nM=-1\n@R13\nA=M\n0;JMP\n";
+	}
+}
@@ -1,22 +1,68 @@
 #pragma once
+#include <cstdint>
 #include <fstream>
+#include <ostream>
+#include <set>
+#include <streambuf>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 
 /*
 * The CodeWriter writes Hack assembly to a file from the given
 * VM commands that are passed to it. It stops writing when
 * it ceases to exist in memory (goes out of scope, for example).
+* It may also write to a stream it is given, such as one in memory.
+*
+* Given a profile, the code of cold functions is made smaller: their
+* call, return, eq, gt and lt commands jump to shared routines instead of
+* being written out in full. Hot functions keep the inline code, which
+* takes fewer cycles but more of the ROM_WORDS words of ROM. So the hot
+* functions are chosen for the whole program, from two translations of it
+* that only count what they write: one with every function cold, and one
+* with every function hot. In order of their own profiled cycles per word
+* their inline code adds, functions are made hot for as long as the
+* program still fits in ROM.
+*
+* Given the static frames of a CallGraph, the locals of those functions
+* are read and written at their fixed addresses, with a single @ each,
+* and are not pushed onto the stack by the function command.
 */
 
+class Parser;
+
 extern const std::string g_TARGET_EXT;
 extern const std::string g_SRC_EXT;
 
 class CodeWriter 
 {
+public:
+	// Number of instructions the Hack ROM holds
+	static const size_t ROM_WORDS = 32768;
 private:
-	// Single output Hack assembly file
-	std::ofstream m_Ofs;
+	/*
+	* Passes the assembly written on to an output, if there is one, and
+	* counts its instructions: the lines that are not labels.
+	*/
+	class InstructionCounter : public std::streambuf
+	{
+	private:
+		std::streambuf* m_Out;
+		size_t m_Count;
+		bool m_LineStart;
+		void Count(char c);
+	protected:
+		int_type overflow(int_type c) override;
+		std::streamsize xsputn(const char* s, std::streamsize n) override;
+		int sync() override { return m_Out ? m_Out->pubsync() : 0; }
+	public:
+		explicit InstructionCounter(std::streambuf* out) :m_Out(out), m_Count(0), m_LineStart(true) {}
+		size_t Count() const { return m_Count; }
+	};
+	// Single output Hack assembly file, if not writing to a given stream
+	std::ofstream m_File;
+	InstructionCounter m_Counter;
+	std::ostream m_Ofs;
 	// Name of VM file currently being translated to assembly
 	std::string m_CurrentFile;
 	std::string m_CurrentFunction;
@@ -24,15 +70,61 @@ private:
 	size_t m_LabelCount;
 	static const std::unordered_map<std::string, std::string> s_CmdMap;
 	static const std::unordered_map<std::string, std::string> s_SgmtMap;
+	static const std::unordered_map<std::string, std::string> s_IfCompareMap;
+	// Whether a profile was loaded, the cycles it gives each function itself, and the functions made hot
+	bool m_Outline;
+	std::unordered_map<std::string, uint64_t> m_Cycles;
+	std::unordered_set<std::string> m_HotFunctions;
+	// Instructions written for each function, and in all when the current function's were last added
+	std::unordered_map<std::string, size_t> m_FunctionWords;
+	size_t m_CountedWords;
+	// Shared routines jumped to so far: numbers of arguments of calls, and eq, gt and lt
+	std::set<int> m_CallRoutines;
+	bool m_ReturnRoutine;
+	std::set<std::string> m_CompareRoutines;
+	// First slot of each function with a static frame, and of the current function's or -1
+	std::unordered_map<std::string, int> m_StaticFrames;
+	int m_FrameSlot;
 
 	// Creates a unique label by using m_LabelCount
 	const std::string UniqueLabel(const std::string& label);
+	// Whether segment is local and lives in the current function's static frame
+	bool IsStaticLocal(const std::string& segment) const { return segment == "local" && m_FrameSlot >= 0; }
+	// Assembler variable of local index in the current function's static frame
+	const std::string FrameSlot(int index) const { return "$frame." + std::to_string(m_FrameSlot + index); }
+	// Whether WriteAddress needs D for segment index
+	bool AddressUsesD(const std::string& segment, int index) const;
+	// Sets A to the address of segment index, and D too if AddressUsesD
+	void WriteAddress(const std::string& segment, int index);
+	// Sets D to the value of segment index
+	void WriteLoad(const std::string& segment, int index);
+	// Whether the current function's commands jump to the shared routines
+	bool IsCold() const { return m_Outline && m_HotFunctions.count(m_CurrentFunction) == 0; }
+	// Writes the code of a return, inline or in the shared routine
+	void WriteReturnCode();
+	// Adds the instructions written since they were last added to those of the current function
+	void CountFunctionWords();
 public:
 	explicit CodeWriter(const std::string& name);
+	explicit CodeWriter(std::ostream& os);
 	~CodeWriter();
 	// Gets ready to translate new VM file
 	void SetFileName(const std::string& name);
+	// Reads a profile written by the emulator with --profile-out; every function is cold until ChooseHotFunctions
+	void LoadProfile(const std::string& path);
+	/*
+	* Makes hot the functions that save the most cycles per word of ROM, given
+	* writers that translated the whole program with every function cold (a
+	* writer that loaded the profile) and hot (one that did not).
+	*/
+	void ChooseHotFunctions(const CodeWriter& cold, const CodeWriter& hot);
+	// Number of instructions written so far
+	size_t Words() const { return m_Counter.Count(); }
+	// Keeps the locals of the functions in frames in static frames from their first slot on
+	void SetStaticFrames(const std::unordered_map<std::string, int>& frames) { m_StaticFrames = frames; }
 
+	// Writes the assembly of the command the parser has just read
+	void WriteCommand(const Parser& parser);
 	// Write assembly output corresponding to given command
 	void WriteArithmetic(const std::string& name);
 	void WritePushPop(const std::string& command, const std::string& segment, int index);
@@ -40,7 +132,13 @@ public:
 	void WriteLabel(const std::string& label);
 	void WriteGoto(const std::string& label);
 	void WriteIf(const std::string& label);
+	void WriteIfCompare(const std::string& command, const std::string& label);
+	void WriteIncDec(const std::string& command, const std::string& segment, int index);
+	void WriteMove(const std::string& srcSegment, int srcIndex, const std::string& dstSegment, int dstIndex);
+	void WritePushOp(const std::string& command, const std::string& segment, int index);
 	void WriteCall(const std::string& functionName, int numArgs);
 	void WriteReturn();
 	void WriteFunction(const std::string& functionName, int numLocals);
+	// Writes the shared routines that cold functions jump to; called after the last command
+	void WriteRoutines();
 };
\ No newline at end of file
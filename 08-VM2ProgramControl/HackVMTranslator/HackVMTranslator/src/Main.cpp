@@ -3,6 +3,8 @@
 #include <vector>
 #include <exception>
 #include <filesystem>
+#include <unordered_map>
+#include "CallGraph.h"
 #include "CodeWriter.h"
 #include "Parser.h"
 #include "InvalidCommand.h"
@@ -16,13 +18,26 @@ void Usage(const std::string& programName);
 
 int main(int argc, char* argv[])
 {
-	if (argc == 1)
+	std::string profile_path;
+	bool static_frames = false;
+	int arg = 1;
+	for (; arg < argc && argv[arg][0] == '-'; arg++)
+	{
+		const std::string option = argv[arg];
+		if (option == "--profile" && arg + 1 < argc)
+			profile_path = argv[++arg];
+		else if (option == "--static-frames")
+			static_frames = true;
+		else
+			break;
+	}
+	if (arg + 1 != argc)
 	{
 		Usage(fs::path(argv[0]).stem().string());
 		return EXIT_FAILURE;
 	}
 	std::vector<fs::path> abs_file_paths;
-	fs::path prgm_path = fs::absolute(argv[1]);
+	fs::path prgm_path = fs::absolute(argv[arg]);
 	if (fs::is_directory(prgm_path))
 	{	// All VM files in given directory
 		for (auto& f : fs::directory_iterator{ prgm_path })
@@ -40,9 +55,58 @@ int main(int argc, char* argv[])
 		program_name = prgm_path.parent_path().stem().string();
 	else                        // "C:\ProgramDir" or "C:\ProgramDir\Program.vm"
 		program_name = prgm_path.stem().string();
-	int line_count;
+	int line_count = 0;
+	size_t words = 0;
 	try {
 		CodeWriter writer{ program_name };
+		std::unordered_map<std::string, int> frames;
+		if (static_frames)
+		{	// A first pass over all files, for the whole program's calls
+			CallGraph graph;
+			for (const fs::path& fp : abs_file_paths)
+			{
+				graph.SetFileName(fp.stem().string());
+				Parser parser{ fp };
+				line_count = 0;
+				while (parser.HasMoreCommands())
+				{
+					line_count++;
+					parser.Advance();
+					graph.AddCommand(parser.Command(), parser.Arg1(), parser.Arg2(), parser.Arg3(), parser.Arg4());
+				}
+			}
+			frames = graph.StaticFrames();
+			writer.SetStaticFrames(frames);
+		}
+		if (!profile_path.empty())
+		{	// Another pass, translating all files with every function cold and hot only to count their words
+			std::ostream discard{ nullptr };
+			CodeWriter cold{ discard }, hot{ discard };
+			cold.LoadProfile(profile_path);
+			for (CodeWriter* sizer : { &cold, &hot })
+			{
+				sizer->SetStaticFrames(frames);
+				sizer->WriteInit();
+			}
+			for (const fs::path& fp : abs_file_paths)
+			{
+				cold.SetFileName(fp.stem().string());
+				hot.SetFileName(fp.stem().string());
+				Parser parser{ fp };
+				line_count = 0;
+				while (parser.HasMoreCommands())
+				{
+					line_count++;
+					parser.Advance();
+					cold.WriteCommand(parser);
+					hot.WriteCommand(parser);
+				}
+			}
+			cold.WriteRoutines();
+			hot.WriteRoutines();
+			writer.LoadProfile(profile_path);
+			writer.ChooseHotFunctions(cold, hot);
+		}
 		writer.WriteInit();
 		for (const fs::path& fp : abs_file_paths)
 		{ 
@@ -56,29 +120,11 @@ int main(int argc, char* argv[])
 			{
 				line_count++;
 				parser.Advance();
-				HackVM::CType ctype = parser.CommandType();
-				if (ctype == HackVM::CType::C_ARITHMETIC)
-					writer.WriteArithmetic(parser.Arg1());
-				else if (ctype == HackVM::CType::C_PUSH)
-					writer.WritePushPop("push", parser.Arg1(), parser.Arg2());
-				else if (ctype == HackVM::CType::C_POP)
-					writer.WritePushPop("pop", parser.Arg1(), parser.Arg2());
-				else if (ctype == HackVM::CType::C_LABEL)
-					writer.WriteLabel(parser.Arg1());
-				else if (ctype == HackVM::CType::C_GOTO)
-					writer.WriteGoto(parser.Arg1());
-				else if (ctype == HackVM::CType::C_IF)
-					writer.WriteIf(parser.Arg1());
-				else if (ctype == HackVM::CType::C_CALL)
-					writer.WriteCall(parser.Arg1(), parser.Arg2());
-				else if (ctype == HackVM::CType::C_RETURN)
-					writer.WriteReturn();
-				else if (ctype == HackVM::CType::C_FUNCTION)
-					writer.WriteFunction(parser.Arg1(), parser.Arg2());
-				else
-					throw HackVM::InvalidCommand(fp.stem().string());
+				writer.WriteCommand(parser);
 			}
 		}
+		writer.WriteRoutines();
+		words = writer.Words();
 	}
 	catch (std::exception& e)
 	{
@@ -86,6 +132,13 @@ int main(int argc, char* argv[])
 		std::cerr << e.what() << std::endl;
 		return EXIT_FAILURE;
 	}
+	if (words > CodeWriter::ROM_WORDS)
+	{	// The program could not run, so no assembly is left for the assembler
+		std::cerr << program_name << g_TARGET_EXT << ": " << words << " instructions, more than the ";
+		std::cerr << CodeWriter::ROM_WORDS << " words of ROM" << std::endl;
+		fs::remove(program_name + g_TARGET_EXT);
+		return EXIT_FAILURE;
+	}
 	return EXIT_SUCCESS;
 }
 
@@ -94,9 +147,14 @@ int main(int argc, char* argv[])
 */
 void Usage(const std::string& programName)
 {
-	std::cerr << "Usage: " << programName << " [FILE|DIR]" << std::endl;
+	std::cerr << "Usage: " << programName << " [--profile FILE] [--static-frames] [FILE|DIR]" << std::endl;
 	std::cerr << "Description: Convert input Hack VM file to assembly." << std::endl;
-	std::cerr << "             If directory, convert all VM files in it to a single assembly file.";
+	std::cerr << "             If directory, convert all VM files in it to a single assembly file." << std::endl;
+	std::cerr << "             With --profile, keep call, return and compare code inline only in the functions" << std::endl;
+	std::cerr << "             that save the most cycles of the emulator's --profile-out profile FILE per word" << std::endl;
+	std::cerr << "             of ROM, as many as fit, and share that code in the others." << std::endl;
+	std::cerr << "             With --static-frames, keep the locals of functions that cannot recurse" << std::endl;
+	std::cerr << "             at fixed addresses instead of on the stack.";
 	std::cerr << std::endl;
 }
 
@@ -17,39 +17,56 @@ const std::unordered_map<std::string, HackVM::CType> Parser::s_CmdMap = {
 	{"label", HackVM::CType::C_LABEL},
 	{"goto", HackVM::CType::C_GOTO},
 	{"if-goto", HackVM::CType::C_IF},
+	{"if-eq", HackVM::CType::C_IF_COMPARE},
+	{"if-ne", HackVM::CType::C_IF_COMPARE},
+	{"if-lt", HackVM::CType::C_IF_COMPARE},
+	{"if-gt", HackVM::CType::C_IF_COMPARE},
+	{"if-le", HackVM::CType::C_IF_COMPARE},
+	{"if-ge", HackVM::CType::C_IF_COMPARE},
+	{"inc", HackVM::CType::C_INC},
+	{"dec", HackVM::CType::C_INC},
+	{"move", HackVM::CType::C_MOVE},
+	{"push-add", HackVM::CType::C_PUSH_OP},
+	{"push-sub", HackVM::CType::C_PUSH_OP},
 	{"function", HackVM::CType::C_FUNCTION},
 	{"return", HackVM::CType::C_RETURN},
 	{"call", HackVM::CType::C_CALL}
 };
 
 Parser::Parser(const std::filesystem::path& fp)
-	:m_Command{ "" }, m_Arg1{ "" }, m_Arg2{ 0 }
+	:m_Ifs{ m_File }, m_Name{ fp.stem().string() },
+	m_Command{ "" }, m_Arg1{ "" }, m_Arg2{ 0 }, m_Arg3{ "" }, m_Arg4{ 0 }
 {
-	m_VMFile.name = fp.stem().string();
-	m_VMFile.ifs.open(fp);
-	if (!m_VMFile.ifs)
+	m_File.open(fp);
+	if (!m_File)
 	{
 		std::stringstream ss;
-		ss << "Problem encountered while opening \"" << m_VMFile.name << "\"";
+		ss << "Problem encountered while opening \"" << m_Name << "\"";
 		throw std::ifstream::failure(ss.str());
 	}
 }
 
+Parser::Parser(std::istream& is, const std::string& name)
+	:m_Ifs{ is }, m_Name{ name },
+	m_Command{ "" }, m_Arg1{ "" }, m_Arg2{ 0 }, m_Arg3{ "" }, m_Arg4{ 0 }
+{
+}
+
 Parser::~Parser()
 {
-	if (m_VMFile.ifs.is_open())
-		m_VMFile.ifs.close();
+	if (m_File.is_open())
+		m_File.close();
 }
 
 bool Parser::HasMoreCommands()
 {
 	char c;
-	while ((c = m_VMFile.ifs.peek()) != EOF)
+	while ((c = m_Ifs.peek()) != EOF)
 	{
 		if (isspace(c))											// Ignore white space
-			m_VMFile.ifs.get();
-		else if (c == '/' && (c = m_VMFile.ifs.peek()) == '/')	// Ignore comments
-			m_VMFile.ifs.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+			m_Ifs.get();
+		else if (c == '/' && (c = m_Ifs.peek()) == '/')	// Ignore comments
+			m_Ifs.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 		else
 			return true;
 	}
@@ -59,18 +76,22 @@ bool Parser::HasMoreCommands()
 void Parser::Advance()
 {
 	std::string line;
-	std::getline(m_VMFile.ifs, line);			// Read line and get ready to parse
+	std::getline(m_Ifs, line);			// Read line and get ready to parse
 	std::stringstream ss{ line };
 	HackVM::CType ctype;
 	ss >> m_Command;
 	if (ss >> m_Arg1 && m_Arg1[0] != '/')		// Argument (non-comment)
+	{
 		ss >> m_Arg2;							// May have second argument
+		if (CommandType() == HackVM::CType::C_MOVE && !(ss >> m_Arg3 >> m_Arg4))
+			throw HackVM::InvalidCommand(m_Name);
+	}
 	else if ((ctype = CommandType()) == HackVM::CType::C_ARITHMETIC)
 		m_Arg1 = m_Command;
 	else if (ctype == HackVM::CType::C_RETURN)	// Return takes no arguments
 		return;
 	else
-		throw HackVM::InvalidCommand(m_VMFile.name);
+		throw HackVM::InvalidCommand(m_Name);
 }
 
 HackVM::CType Parser::CommandType() const
@@ -1,5 +1,6 @@
 #pragma once
 #include <fstream>
+#include <istream>
 #include <string>
 #include <unordered_map>
 #include <filesystem>
@@ -14,6 +15,10 @@ namespace HackVM {
 		C_LABEL,
 		C_GOTO,
 		C_IF,
+		C_IF_COMPARE,	// Extended VM: if-eq, if-ne, if-lt, if-gt, if-le, if-ge
+		C_INC,			// Extended VM: inc, dec
+		C_MOVE,			// Extended VM: move
+		C_PUSH_OP,		// Extended VM: push-add, push-sub
 		C_FUNCTION,
 		C_RETURN,
 		C_CALL,
@@ -21,26 +26,32 @@ namespace HackVM {
 	};
 }
 
-// Wrapper for the input VM file that is to be parsed
-static struct VMFile
-{
-	std::ifstream ifs;
-	std::string name;
-};
-
+/*
+* Parses the VM commands of a VM file, or of a stream it is given, such
+* as one over VM code in memory.
+*/
 class Parser
 {
 private:
-	VMFile m_VMFile;
+	// Input VM file, if not reading a given stream
+	std::ifstream m_File;
+	std::istream& m_Ifs;
+	// Name of the VM file, for error messages
+	std::string m_Name;
 	// Current command parsed from file stream
 	std::string m_Command;
 	// First argument of current command (if any)
 	std::string m_Arg1;
 	// Second argument of current command (if any)
 	int m_Arg2;
+	// Destination segment and index of a move command
+	std::string m_Arg3;
+	int m_Arg4;
 	static const std::unordered_map<std::string, HackVM::CType> s_CmdMap;
 public:
 	explicit Parser(const std::filesystem::path& name);
+	// Reads VM code from is, reporting errors in the VM file of the given name
+	Parser(std::istream& is, const std::string& name);
 	~Parser();
 
 	// Checks if there are more VM commands
@@ -51,7 +62,10 @@ public:
 
 	HackVM::CType CommandType() const;
 
+	const std::string& Command() const { return m_Command; }
 	// Command arguments (if any)
 	std::string Arg1() const { return m_Arg1; }
 	int Arg2() const { return m_Arg2; }
+	std::string Arg3() const { return m_Arg3; }
+	int Arg4() const { return m_Arg4; }
 };
\ No newline at end of file
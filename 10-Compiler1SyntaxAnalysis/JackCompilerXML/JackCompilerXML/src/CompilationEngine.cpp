@@ -2,13 +2,9 @@
 #include "JackTokenError.h"
 
 
-CompilationEngine::CompilationEngine(const std::filesystem::path& srcPath)
-	:m_Tokenizer{ srcPath }
-{
-	m_Ofs.open(srcPath.stem().string() + g_TARGET_EXT);
-	if (!m_Ofs)
-		throw std::ofstream::failure("Problem encountered while creating " + srcPath.stem().string());
-}
+CompilationEngine::CompilationEngine(const std::filesystem::path& srcPath, XmlWriter& writer)
+	:m_Tokenizer{ srcPath }, m_Writer{ writer }
+{}
 
 void CompilationEngine::CompileClass()
 {
@@ -17,7 +13,7 @@ void CompilationEngine::CompileClass()
 		m_Tokenizer.Advance();
 		if (m_Tokenizer.TokenType() != JackTokenType::KEYWORD || m_Tokenizer.KeyWord() != "class")
 			throw JackTokenError("Expected class");
-		m_Ofs << "<class>\n";
+		m_Writer.Write("<class>\n");
 		CompileKeyWord("class");
 		CompileIdentifier();
 		CompileSymbol('{');
@@ -31,13 +27,13 @@ void CompilationEngine::CompileClass()
 				m_Tokenizer.KeyWord() == "function"))
 			CompileSubroutine();
 		CompileSymbol('}');
-		m_Ofs << "</class>\n";
+		m_Writer.Write("</class>\n");
 	}
 }
 
 void CompilationEngine::CompileClassVarDec()
 {
-	m_Ofs << "<classVarDec>\n";
+	m_Writer.Write("<classVarDec>\n");
 	CompileKeyWord(m_Tokenizer.KeyWord());
 	CompileType();
 	CompileIdentifier();
@@ -48,12 +44,12 @@ void CompilationEngine::CompileClassVarDec()
 		CompileIdentifier();
 	}
 	CompileSymbol(';');
-	m_Ofs << "</classVarDec>\n";
+	m_Writer.Write("</classVarDec>\n");
 }
 
 void CompilationEngine::CompileSubroutine()
 {
-	m_Ofs << "<subroutineDec>\n";
+	m_Writer.Write("<subroutineDec>\n");
 	// Subroutine header.
 	CompileKeyWord(m_Tokenizer.KeyWord());
 	// Return type may be void, primitive-type, or user-defined type.
@@ -67,21 +63,21 @@ void CompilationEngine::CompileSubroutine()
 	CompileSymbol(')');
 
 	// Subroutine body.
-	m_Ofs << "<subroutineBody>\n";
+	m_Writer.Write("<subroutineBody>\n");
 	CompileSymbol('{');
 	// All variable declarations must appear at start of subroutine.
 	while (m_Tokenizer.TokenType() == JackTokenType::KEYWORD && m_Tokenizer.KeyWord() == "var")
 		CompileVarDec();
 	CompileStatements();
 	CompileSymbol('}');
-	m_Ofs << "</subroutineBody>\n";
-	m_Ofs << "</subroutineDec>\n";
+	m_Writer.Write("</subroutineBody>\n");
+	m_Writer.Write("</subroutineDec>\n");
 
 }
 
 void CompilationEngine::CompileParameterList()
 {
-	m_Ofs << "<parameterList>\n";
+	m_Writer.Write("<parameterList>\n");
 	// Possibly empty parameter list.
 	if (m_Tokenizer.TokenType() != JackTokenType::SYMBOL || m_Tokenizer.Symbol() != ')')
 	{
@@ -95,12 +91,12 @@ void CompilationEngine::CompileParameterList()
 			CompileIdentifier();
 		}
 	}
-	m_Ofs << "</parameterList>\n";
+	m_Writer.Write("</parameterList>\n");
 }
 
 void CompilationEngine::CompileVarDec()
 {
-	m_Ofs << "<varDec>\n";
+	m_Writer.Write("<varDec>\n");
 	CompileKeyWord("var");
 	CompileType();
 	CompileIdentifier();
@@ -111,15 +107,15 @@ void CompilationEngine::CompileVarDec()
 		CompileIdentifier();
 	}
 	CompileSymbol(';');
-	m_Ofs << "</varDec>\n";
+	m_Writer.Write("</varDec>\n");
 }
 
 void CompilationEngine::CompileStatements()
 {
-	m_Ofs << "<statements>\n";
+	m_Writer.Write("<statements>\n");
 	while (m_Tokenizer.TokenType() == JackTokenType::KEYWORD)
 	{
-		const std::string kw = m_Tokenizer.KeyWord();
+		const std::string_view kw = m_Tokenizer.KeyWord();
 		if (kw == "do")
 			CompileDo();
 		else if (kw == "let")
@@ -131,14 +127,14 @@ void CompilationEngine::CompileStatements()
 		else if (kw == "if")
 			CompileIf();
 		else
-			throw JackTokenError(std::string("Unexpected keyword ") + kw);
+			throw JackTokenError("Unexpected keyword " + std::string(kw));
 	}
-	m_Ofs << "</statements>\n";
+	m_Writer.Write("</statements>\n");
 }
 
 void CompilationEngine::CompileDo()
 {
-	m_Ofs << "<doStatement>\n";
+	m_Writer.Write("<doStatement>\n");
 	CompileKeyWord("do");
 	// Subroutine may be a method of this class, or of another class.
 	CompileIdentifier();
@@ -151,12 +147,12 @@ void CompilationEngine::CompileDo()
 	CompileExpressionList();
 	CompileSymbol(')');
 	CompileSymbol(';');
-	m_Ofs << "</doStatement>\n";
+	m_Writer.Write("</doStatement>\n");
 }
 
 void CompilationEngine::CompileLet()
 {
-	m_Ofs << "<letStatement>\n";
+	m_Writer.Write("<letStatement>\n");
 	CompileKeyWord("let");
 	CompileIdentifier();
 	if (m_Tokenizer.TokenType() == JackTokenType::SYMBOL && m_Tokenizer.Symbol() == '[')
@@ -168,12 +164,12 @@ void CompilationEngine::CompileLet()
 	CompileSymbol('=');
 	CompileExpression();
 	CompileSymbol(';');
-	m_Ofs << "</letStatement>\n";
+	m_Writer.Write("</letStatement>\n");
 }
 
 void CompilationEngine::CompileWhile()
 {
-	m_Ofs << "<whileStatement>\n";
+	m_Writer.Write("<whileStatement>\n");
 	CompileKeyWord("while");
 	CompileSymbol('(');
 	CompileExpression();
@@ -181,23 +177,23 @@ void CompilationEngine::CompileWhile()
 	CompileSymbol('{');
 	CompileStatements();
 	CompileSymbol('}');
-	m_Ofs << "</whileStatement>\n";
+	m_Writer.Write("</whileStatement>\n");
 }
 
 void CompilationEngine::CompileReturn()
 {
-	m_Ofs << "<returnStatement>\n";
+	m_Writer.Write("<returnStatement>\n");
 	CompileKeyWord("return");
 	// Possibl empty return statement.
 	if (m_Tokenizer.TokenType() != JackTokenType::SYMBOL || m_Tokenizer.Symbol() != ';')
 		CompileExpression();
 	CompileSymbol(';');
-	m_Ofs << "</returnStatement>\n";
+	m_Writer.Write("</returnStatement>\n");
 }
 
 void CompilationEngine::CompileIf()
 {
-	m_Ofs << "<ifStatement>\n";
+	m_Writer.Write("<ifStatement>\n");
 	CompileKeyWord("if");
 	CompileSymbol('(');
 	CompileExpression();
@@ -213,12 +209,12 @@ void CompilationEngine::CompileIf()
 		CompileStatements();
 		CompileSymbol('}');
 	}
-	m_Ofs << "</ifStatement>\n";
+	m_Writer.Write("</ifStatement>\n");
 }
 
 void CompilationEngine::CompileExpression()
 {
-	m_Ofs << "<expression>\n";
+	m_Writer.Write("<expression>\n");
 	CompileTerm();
 	if (m_Tokenizer.TokenType() == JackTokenType::SYMBOL)
 	{
@@ -231,30 +227,30 @@ void CompilationEngine::CompileExpression()
 			CompileTerm();
 		}
 	}
-	m_Ofs << "</expression>\n";
+	m_Writer.Write("</expression>\n");
 }
 
 void CompilationEngine::CompileTerm()
 {
-	m_Ofs << "<term>\n";
+	m_Writer.Write("<term>\n");
 	JackTokenType t = m_Tokenizer.TokenType();
 	if (t == JackTokenType::INT_CONST)
 	{
-		m_Ofs << "<integerConstant> " << m_Tokenizer.IntVal() << " </integerConstant>\n";
+		m_Writer.WriteTerminal(m_Tokenizer.IntVal());
 		if (m_Tokenizer.HasMoreTokens())
 			m_Tokenizer.Advance();
 	}
 	else if (t == JackTokenType::STRING_CONST)
 	{
-		m_Ofs << "<stringConstant> " << m_Tokenizer.StringVal() << " </stringConstant>\n";
+		m_Writer.WriteTerminal(JackTokenType::STRING_CONST, m_Tokenizer.StringVal());
 		if (m_Tokenizer.HasMoreTokens())
 			m_Tokenizer.Advance();
 	}
 	else if (t == JackTokenType::KEYWORD)
 	{
-		const std::string kw = m_Tokenizer.KeyWord();
+		const std::string_view kw = m_Tokenizer.KeyWord();
 		if (kw != "null" && kw != "true" && kw != "false" && kw != "this")
-			throw JackTokenError(std::string("Unexpected keyword ") + kw);
+			throw JackTokenError("Unexpected keyword " + std::string(kw));
 		CompileKeyWord(kw);
 	}
 	else if (t == JackTokenType::SYMBOL)
@@ -301,13 +297,13 @@ void CompilationEngine::CompileTerm()
 		}
 	}
 	else
-		throw JackTokenError(m_Tokenizer.Identifier());
-	m_Ofs << "</term>\n";
+		throw JackTokenError(std::string(m_Tokenizer.Identifier()));
+	m_Writer.Write("</term>\n");
 }
 
 void CompilationEngine::CompileExpressionList()
 {
-	m_Ofs << "<expressionList>\n";
+	m_Writer.Write("<expressionList>\n");
 	JackTokenType t = m_Tokenizer.TokenType();
 	if (t != JackTokenType::SYMBOL || m_Tokenizer.Symbol() != ')')
 	{
@@ -318,21 +314,14 @@ void CompilationEngine::CompileExpressionList()
 			CompileExpression();
 		}
 	}
-	m_Ofs << "</expressionList>\n";
+	m_Writer.Write("</expressionList>\n");
 }
 
 void CompilationEngine::CompileSymbol(char c)
 {
 	if (m_Tokenizer.TokenType() != JackTokenType::SYMBOL || m_Tokenizer.Symbol() != c)
 		throw JackTokenError(std::string("Expected ") + c);
-	if (c == '<')
-		m_Ofs << "<symbol> &lt; </symbol>\n";
-	else if (c == '>')
-		m_Ofs << "<symbol> &gt; </symbol>\n";
-	else if (c == '&')
-		m_Ofs << "<symbol> &amp; </symbol>\n";
-	else
-		m_Ofs << "<symbol> " << c << " </symbol>\n";
+	m_Writer.WriteTerminal(JackTokenType::SYMBOL, std::string_view(&c, 1));
 	if (m_Tokenizer.HasMoreTokens())
 		m_Tokenizer.Advance();
 }
@@ -341,16 +330,16 @@ void CompilationEngine::CompileIdentifier()
 {
 	if (m_Tokenizer.TokenType() != JackTokenType::IDENTIFIER)
 		throw JackTokenError("Expected identifier");
-	m_Ofs << "<identifier> " << m_Tokenizer.Identifier() << " </identifier>\n";
+	m_Writer.WriteTerminal(JackTokenType::IDENTIFIER, m_Tokenizer.Identifier());
 	if (m_Tokenizer.HasMoreTokens())
 		m_Tokenizer.Advance();
 }
 
-void CompilationEngine::CompileKeyWord(const std::string& kw)
+void CompilationEngine::CompileKeyWord(std::string_view kw)
 {
 	if (m_Tokenizer.KeyWord() != kw)
-		throw JackTokenError(std::string("Expected ") + kw);
-	m_Ofs << "<keyword> " << kw << " </keyword>\n";
+		throw JackTokenError("Expected " + std::string(kw));
+	m_Writer.WriteTerminal(JackTokenType::KEYWORD, kw);
 	if (m_Tokenizer.HasMoreTokens())
 		m_Tokenizer.Advance();
 }
@@ -362,7 +351,7 @@ void CompilationEngine::CompileType()
 		CompileIdentifier();
 	else if (type == JackTokenType::KEYWORD)
 	{
-		const std::string kw = m_Tokenizer.KeyWord();
+		const std::string_view kw = m_Tokenizer.KeyWord();
 		if (kw != "int" && kw != "char" && kw != "boolean")
 			throw JackTokenError("Expected primitive type");
 		CompileKeyWord(kw);
@@ -1,22 +1,21 @@
 #pragma once
 #include <filesystem>
 #include <string>
-#include <fstream>
+#include <string_view>
 #include "JackTokenizer.h"
-
-extern const std::string g_TARGET_EXT;
+#include "XmlWriter.h"
 
 /*
 * Uses the parsed Tokens from the JackTokenizer as its input
-* and uses recursive descent parsing to emit an XML file in a way
+* and uses recursive descent parsing to emit the XML of a class in a way
 * that adheres to Jack's grammar.
 */
 class CompilationEngine
 {
 private:
 	JackTokenizer m_Tokenizer;
-	// Output XML file
-	std::ofstream m_Ofs;
+	// Receives the XML of the class.
+	XmlWriter& m_Writer;
 
 	/*
 	* The following are helper methods. Each of them check for
@@ -24,7 +23,7 @@ private:
 	*/
 	void CompileSymbol(char c);
 	void CompileIdentifier();
-	void CompileKeyWord(const std::string& kw);
+	void CompileKeyWord(std::string_view kw);
 
 	// Outputs an identifier (user-defined type) or non-void primitive type (keyword).
 	void CompileType();
@@ -44,8 +43,8 @@ private:
 	void CompileTerm();
 	void CompileExpressionList();
 public:
-	// Creates a Tokenizer and output XML file to write to.
-	CompilationEngine(const std::filesystem::path& srcPath);
+	// Creates a Tokenizer for the source file, and writes its XML to writer.
+	CompilationEngine(const std::filesystem::path& srcPath, XmlWriter& writer);
 
 	// Creates the XML for the class provided upon construction.
 	void CompileClass();
@@ -1,135 +1,177 @@
+#include <array>
+#include <cstring>			// std::memchr
+#include <fstream>
 #include "JackTokenizer.h"
 #include "JackTokenError.h"
 
-
-const std::unordered_set<std::string> JackTokenizer::s_KWSet = {
+const std::string_view JackTokenizer::s_KWs[] = {
 	"class", "constructor", "function",  "method",  "field",
 	"static", "var", "int", "char", "boolean", "void",
 	"true", "false", "null", "this", "let", "do", "if",
 	"else", "while", "return",
 };
 
-const std::unordered_set<char> JackTokenizer::s_SymSet = {
-	'{', '}', '(', ')', '[', ']', '.',
-	',', ';', '+', '-', '*', '/', '&',
-	'|', '<', '>', '=', '~'
+const int JackTokenizer::s_MAX_INT = 32767;
+
+namespace {
+/* What a character can start, or continue, in Jack source. */
+enum class CharClass : unsigned char
+{
+	OTHER, SPACE, SYMBOL, SLASH, DIGIT, LETTER, QUOTE
 };
 
-const int JackTokenizer::s_MAX_INT = 32767;
+/* Class of each byte, for the tokenizer to dispatch on with a single load. */
+struct CharClasses
+{
+	CharClass of[256];
+
+	constexpr CharClasses() :of{}
+	{
+		for (const char c : " \t\n\v\f\r")
+			of[static_cast<unsigned char>(c)] = CharClass::SPACE;
+		// Valid Jack symbols; '/' may also start a comment.
+		for (const char c : "{}()[].,;+-*&|<>=~")
+			of[static_cast<unsigned char>(c)] = CharClass::SYMBOL;
+		of[static_cast<unsigned char>('/')] = CharClass::SLASH;
+		for (int c = '0'; c <= '9'; c++)
+			of[c] = CharClass::DIGIT;
+		for (int c = 'a'; c <= 'z'; c++)
+			of[c] = of[c - 'a' + 'A'] = CharClass::LETTER;
+		of[static_cast<unsigned char>('_')] = CharClass::LETTER;
+		of[static_cast<unsigned char>('"')] = CharClass::QUOTE;
+		of[0] = CharClass::OTHER;	// The terminator of the strings above.
+	}
+	CharClass operator[](char c) const { return of[static_cast<unsigned char>(c)]; }
+};
+
+constexpr CharClasses CHAR_CLASSES;
+
+/*
+* A hash without collisions over the Jack keywords, so that an identifier
+* is compared with one keyword at most.
+*/
+unsigned KeyWordHash(std::string_view text)
+{
+	return (static_cast<unsigned>(text.size()) + 5u * text.front() + 11u * text.back()) & 63u;
+}
+} // namespace
+
+bool JackTokenizer::IsKeyWord(std::string_view text)
+{
+	// Keyword with each hash, or empty.
+	static const auto table = []() {
+		std::array<std::string_view, 64> kws;
+		for (std::string_view kw : s_KWs)
+			kws[KeyWordHash(kw)] = kw;
+		return kws;
+	}();
+	return table[KeyWordHash(text)] == text;
+}
 
 JackTokenizer::JackTokenizer(const std::filesystem::path& path)
+	:m_Pos{ 0 }, m_Type{ JackTokenType::INVALID }, m_IntVal{ 0 }
 {
-	m_Ifs.open(path.string());
-	if (!m_Ifs) {
+	std::ifstream ifs{ path, std::ios::binary | std::ios::ate };
+	if (!ifs) {
 		std::string msg = "Problem encountered while opening \"" + path.string() + "\"";
 		throw std::ifstream::failure(msg.c_str());
 	}
+	// Read the whole file with a single read of its size.
+	m_Source.resize(static_cast<size_t>(ifs.tellg()));
+	ifs.seekg(0, std::ios::beg);
+	ifs.read(m_Source.data(), m_Source.size());
+	m_Source.resize(static_cast<size_t>(ifs.gcount()));
 }
 
-JackTokenizer::~JackTokenizer()
-{
-	if (m_Ifs.is_open())
-		m_Ifs.close();
-}
-
+/*
+* Skips white space and comments. Comments are skipped with memchr, which
+* the C library implements with vector instructions.
+*/
 bool JackTokenizer::HasMoreTokens()
 {
-	char c;
-	while ((c = m_Ifs.peek()) != EOF)
+	const char* const begin = m_Source.data();
+	const char* const end = begin + m_Source.size();
+	const char* p = begin + m_Pos;
+	while (p < end)
 	{
-		if (isspace(c))
-			m_Ifs.get();
-		else if ((c = m_Ifs.get()) == '/' && m_Ifs.peek() == '/')	// End-of-line comment.
-			m_Ifs.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-		else if (c == '/' && m_Ifs.peek() == '*')					// Multiline/Doc comment.
+		if (CHAR_CLASSES[*p] == CharClass::SPACE)
+			p++;
+		else if (*p == '/' && p + 1 < end && p[1] == '/')		// End-of-line comment.
 		{
-			m_Ifs.get();			// Consume the '*'.
-			char c2 = m_Ifs.get();	// Multiline comment ends with */.
-			while (((c = m_Ifs.get()) != '/' && c != EOF) || c2 != '*')	// Order of || matters.
-				c2 = c;
-			if (c == EOF)
-				throw JackTokenError("Expected '*/'");
+			p = static_cast<const char*>(std::memchr(p, '\n', end - p));
+			if (!p)
+				p = end;
 		}
-		else {
-			m_Ifs.putback(c);		// Character from end-of-line comment branch.
-			return true;
+		else if (*p == '/' && p + 1 < end && p[1] == '*')		// Multiline/Doc comment.
+		{
+			for (p += 2; ; p++)
+			{
+				p = static_cast<const char*>(std::memchr(p, '*', end - p));
+				if (!p || p + 1 == end)
+					throw JackTokenError("Expected '*/'");
+				if (p[1] == '/')
+					break;
+			}
+			p += 2;
 		}
+		else
+			break;
 	}
-	return false;
+	m_Pos = p - begin;
+	return p < end;
 }
 
 void JackTokenizer::Advance()
 {
-	char c = m_Ifs.get();		// HasMoreTokens() guarantees c is not EOF.
-	m_CurrentToken = c;
-	if (s_SymSet.find(c) != s_SymSet.end())			// Symbol; already assigned above.
-		return;
-	else if (isdigit(c))							// Possibly an integer constant
+	const char* const end = m_Source.data() + m_Source.size();
+	const char* p = m_Source.data() + m_Pos;	// HasMoreTokens() guarantees p is before end.
+	const char* start = p;
+	const char c = *p;
+	switch (CHAR_CLASSES[c])
 	{
-		while (isdigit(m_Ifs.peek()))
-			m_CurrentToken += m_Ifs.get();
-		if (std::stoi(m_CurrentToken) > s_MAX_INT)
-			throw new JackTokenError("Integer " + m_CurrentToken + " too large");
+	case CharClass::SYMBOL:
+	case CharClass::SLASH:
+		m_Type = JackTokenType::SYMBOL;
+		p++;
+		break;
+	case CharClass::DIGIT:							// Integer constant.
+	{
+		long value = 0;
+		for (; p < end && CHAR_CLASSES[*p] == CharClass::DIGIT; p++)
+			if ((value = value * 10 + (*p - '0')) > s_MAX_INT)
+				value = s_MAX_INT + 1L;
+		if (value > s_MAX_INT)
+			throw JackTokenError("Integer " + std::string(start, p) + " too large");
+		m_Type = JackTokenType::INT_CONST;
+		m_IntVal = static_cast<int>(value);
+		break;
 	}
-	else if (c == '"')								// Possibly a string constant.
+	case CharClass::QUOTE:							// String constant.
 	{
-		char c2 = c;
-		while ((c2 == '\\' || (c = m_Ifs.get()) != '"') && c != EOF) {
-			m_CurrentToken += c;					// Allow character escape sequences,
-			c2 = c;									// including \".
+		start = ++p;
+		const char* close = static_cast<const char*>(std::memchr(p, '"', end - p));
+		if (close && std::memchr(p, '\\', close - p))
+		{	// Allow character escape sequences, including \".
+			for (; p < end && *p != '"'; p++)
+				if (*p == '\\' && p + 1 < end)
+					p++;
+			close = (p < end) ? p : nullptr;
 		}
-		if (c2 == EOF)								// Discard closing ".
+		if (!close)
 			throw JackTokenError("Expected \"");
+		m_Type = JackTokenType::STRING_CONST;
+		m_CurrentToken = std::string_view(start, close - start);
+		m_Pos = close + 1 - m_Source.data();		// Discard closing ".
+		return;
 	}
-	else if (isalnum(c) || c == '_')				// Identifier (variableName, className..).
-		while ((isalnum(c = m_Ifs.peek()) || c == '_') && c != EOF)
-			m_CurrentToken += (c = m_Ifs.get());
-	else
-		throw JackTokenError("Unexpected " + c);
-}
-
-JackTokenType JackTokenizer::TokenType()
-{
-	if (s_SymSet.find(m_CurrentToken[0]) != s_SymSet.end())
-		return JackTokenType::SYMBOL;
-	else if (isdigit(m_CurrentToken[0]))
-		return JackTokenType::INT_CONST;
-	else if (m_CurrentToken[0] == '"')
-		return JackTokenType::STRING_CONST;
-	else if (s_KWSet.find(m_CurrentToken) != s_KWSet.end())
-		return JackTokenType::KEYWORD;
-	else if (isalnum(m_CurrentToken[0]) || m_CurrentToken[0] == '_')
-		return JackTokenType::IDENTIFIER;
-	else
-		return JackTokenType::INVALID;
-}
-
-/* Should only be called if TokenType() == KEYWORD. */
-const std::string JackTokenizer::KeyWord()
-{
-	return m_CurrentToken;
-}
-
-/* Should only be called if TokenType() == SYMBOL. */
-char JackTokenizer::Symbol()
-{
-	return m_CurrentToken[0];
-}
-
-/* Should only be called if TokenType() == IDENTIFIER. */
-const std::string JackTokenizer::Identifier()
-{
-	return m_CurrentToken;
-}
-
-/* Should only be called if TokenType() == INT_CONST. */
-int JackTokenizer::IntVal()
-{
-	return std::stoi(m_CurrentToken);
-}
-
-/* Should only be called if TokenType() == STRING_CONST. */
-const std::string JackTokenizer::StringVal()
-{
-	return m_CurrentToken.substr(1); // Omit the opening " (has no ending ").
+	case CharClass::LETTER:							// Keyword or identifier (variableName, className..).
+		while (++p < end && (CHAR_CLASSES[*p] == CharClass::LETTER || CHAR_CLASSES[*p] == CharClass::DIGIT))
+			;
+		m_Type = IsKeyWord(std::string_view(start, p - start)) ? JackTokenType::KEYWORD : JackTokenType::IDENTIFIER;
+		break;
+	default:
+		throw JackTokenError(std::string("Unexpected ") + c);
+	}
+	m_CurrentToken = std::string_view(start, p - start);
+	m_Pos = p - m_Source.data();
 }
@@ -1,8 +1,7 @@
 #pragma once
 #include <string>
-#include <fstream>
+#include <string_view>
 #include <filesystem>
-#include <unordered_set>
 
 /* Types of Lexical Elements of the Jack programming language. */
 enum class JackTokenType
@@ -14,35 +13,42 @@ enum class JackTokenType
 * The JackTokenizer class parses an input jack source file
 * (with a ".jack" extension) into its terminal elements (tokens).
 * It also ignores white spaces and any valid type of comment.
+*
+* The whole file is read into memory at once, and tokens are scanned from
+* it as they are asked for. Keywords, identifiers and string constants are
+* returned as views of that copy of the file, so no token is ever copied.
 */
 class JackTokenizer
 {
 private:
 	// Valid Jack Keywords.
-	static const std::unordered_set<std::string> s_KWSet;
-	// Valid Jack symbols.
-	static const std::unordered_set<char> s_SymSet;
+	static const std::string_view s_KWs[];
 	// Maximum integer constant in Jack.
 	static const int s_MAX_INT;
 
-	// Input filestream for the relevant Jack source file.
-	std::ifstream m_Ifs;
-	// Current Jack token parsed from stream.
-	std::string m_CurrentToken;
+	// Whole source file.
+	std::string m_Source;
+	// Offset in m_Source of the next character to scan.
+	size_t m_Pos;
+	JackTokenType m_Type;
+	// Current token; for a string constant, without its quotes.
+	std::string_view m_CurrentToken;
+	int m_IntVal;
+
+	static bool IsKeyWord(std::string_view text);
 public:
-	// Gets file stream ready for parsing.
+	// Reads the whole source file.
 	JackTokenizer(const std::filesystem::path& path);
-	~JackTokenizer();
 	// Asserts that there is a token to be read (non-comment/white space).
 	bool HasMoreTokens();
 	// Sets the current token in the stream (should call only if HasMoreTokens() is true).
 	void Advance();
-	JackTokenType TokenType();
+	JackTokenType TokenType() const { return m_Type; }
 
 	// Returns value of current token (after asserting its type with TokenType()).
-	const std::string KeyWord();
-	char Symbol();
-	const std::string Identifier();
-	int IntVal();
-	const std::string StringVal();
-};
\ No newline at end of file
+	std::string_view KeyWord() const { return m_CurrentToken; }
+	char Symbol() const { return m_Type == JackTokenType::SYMBOL ? m_CurrentToken[0] : '\0'; }
+	std::string_view Identifier() const { return m_CurrentToken; }
+	int IntVal() const { return m_IntVal; }
+	std::string_view StringVal() const { return m_CurrentToken; }
+};
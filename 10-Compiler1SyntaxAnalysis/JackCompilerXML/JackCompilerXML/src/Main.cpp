@@ -3,25 +3,73 @@
 #include <vector>
 #include <exception>
 #include <filesystem>
-#include <fstream>
+#include <thread>
+#include <future>
+#include <atomic>
+#include <algorithm>
 #include "CompilationEngine.h"
+#include "XmlWriter.h"
 
 namespace fs = std::filesystem;
 
 const std::string g_SRC_EXT = ".jack";
 const std::string g_TARGET_EXT = ".xml";
+// Appended to the class name for the token stream's XML file, as in MainT.xml.
+const std::string g_TOKENS_SUFFIX = "T";
+
+// What is made of each Jack file.
+enum class Mode
+{
+	TREE,		// XML of the parse tree.
+	TOKENS,		// XML of the token stream only.
+	CHECK		// Only whether the class parses.
+};
 
 void Usage(const std::string& programName);
+std::string Analyze(const fs::path& path, Mode mode);
 
+/*
+* Convert Jack classes to XML
+*
+* Input:	A Jack file (.jack extension) or a directory of them, optionally
+*			preceded by -j N to analyze N files at a time, and --tokens
+*			to write only each file's tokens or --check to write nothing
+*			and only report errors
+* Output:	An XML file (.xml extension) per class in current directory
+*/
 int main(int argc, char* argv[])
 {
-	if (argc == 1)
+	const std::string program_name = fs::path(argv[0]).stem().string();
+	unsigned jobs = 1;
+	Mode mode = Mode::TREE;
+	int arg = 1;
+	try
+	{
+		for (; arg < argc && argv[arg][0] == '-'; arg++)
+		{
+			const std::string option = argv[arg];
+			if (option == "-j" && arg + 1 < argc)
+				jobs = std::max(1, std::stoi(argv[++arg]));
+			else if (option == "--tokens")
+				mode = Mode::TOKENS;
+			else if (option == "--check")
+				mode = Mode::CHECK;
+			else
+				throw std::invalid_argument(option);
+		}
+	}
+	catch (const std::exception&)
+	{
+		Usage(program_name);
+		return EXIT_FAILURE;
+	}
+	if (arg + 1 != argc)
 	{
-		Usage(fs::path(argv[0]).stem().string());
+		Usage(program_name);
 		return EXIT_FAILURE;
 	}
 	std::vector<fs::path> abs_file_paths;
-	fs::path prgm_path = fs::absolute(argv[1]);
+	fs::path prgm_path = fs::absolute(argv[arg]);
 	if (fs::is_directory(prgm_path))
 	{	// All Jack files in given directory.
 		for (auto& f : fs::directory_iterator{ prgm_path })
@@ -31,24 +79,90 @@ int main(int argc, char* argv[])
 	else if (fs::is_regular_file(prgm_path) && prgm_path.extension() == g_SRC_EXT)
 		abs_file_paths.push_back(prgm_path);
 	else {
-		Usage(fs::path(argv[0]).stem().string());
+		Usage(program_name);
 		return EXIT_FAILURE;
 	}
-	try 
+	/*
+	* Files are independent, so each worker takes the next file not yet
+	* taken. Results are reported in file order, and every file is analyzed
+	* even after one fails, so that a check reports all errors at once.
+	*/
+	const size_t n_files = abs_file_paths.size();
+	std::vector<std::promise<std::string>> promises(n_files);
+	std::vector<std::future<std::string>> errors;
+	for (auto& promise : promises)
+		errors.push_back(promise.get_future());
+	std::atomic<size_t> next_file{ 0 };
+	auto work = [&]() {
+		for (size_t i; (i = next_file++) < n_files; )
+			promises[i].set_value(Analyze(abs_file_paths[i], mode));
+	};
+	std::vector<std::thread> workers;
+	for (size_t t = 1; t < std::min<size_t>(jobs, n_files); t++)
+		workers.emplace_back(work);
+	work();
+	bool ok = true;
+	for (size_t i = 0; i < n_files; i++)
 	{
-		for (const fs::path& p : abs_file_paths)
+		const std::string error = errors[i].get();
+		if (mode != Mode::CHECK)
+			std::cout << "Processing " << abs_file_paths[i].string() << std::endl;
+		if (!error.empty())
 		{
-			std::cout << "Processing " << p.string() << std::endl;
-			CompilationEngine engine{ p };
+			std::cerr << abs_file_paths[i].string() << ": " << error << std::endl;
+			ok = false;
+		}
+	}
+	for (std::thread& worker : workers)
+		worker.join();
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*
+* Makes what mode asks of the Jack file at path, writing any XML file to
+* the current directory; returns the error message, if any. As before, the
+* XML written up to an error is kept.
+*/
+std::string Analyze(const fs::path& path, Mode mode)
+{
+	std::string error;
+	XmlWriter writer{ mode != Mode::CHECK };
+	try
+	{
+		if (mode == Mode::TOKENS)
+		{
+			JackTokenizer tokenizer{ path };
+			writer.Write("<tokens>\n");
+			while (tokenizer.HasMoreTokens())
+			{
+				tokenizer.Advance();
+				const JackTokenType type = tokenizer.TokenType();
+				if (type == JackTokenType::SYMBOL)
+				{
+					const char c = tokenizer.Symbol();
+					writer.WriteTerminal(type, std::string_view(&c, 1));
+				}
+				else if (type == JackTokenType::INT_CONST)
+					writer.WriteTerminal(tokenizer.IntVal());
+				else
+					writer.WriteTerminal(type, tokenizer.Identifier());
+			}
+			writer.Write("</tokens>\n");
+		}
+		else
+		{
+			CompilationEngine engine{ path, writer };
 			engine.CompileClass();
 		}
 	}
-	catch (std::exception& e)
+	catch (const std::exception& e)
 	{
-		std::cerr << e.what() << std::endl;
-		return EXIT_FAILURE;
+		error = e.what();
 	}
-	return EXIT_SUCCESS;
+	const std::string target = path.stem().string() + (mode == Mode::TOKENS ? g_TOKENS_SUFFIX : "") + g_TARGET_EXT;
+	if (mode != Mode::CHECK && !writer.Save(target) && error.empty())
+		error = "Problem encountered while creating " + target;
+	return error;
 }
 
 /*
@@ -56,8 +170,11 @@ int main(int argc, char* argv[])
 */
 void Usage(const std::string& programName)
 {
-	std::cerr << "Usage: " << programName << " [FILE|DIR]" << std::endl;
+	std::cerr << "Usage: " << programName << " [-j N] [--tokens|--check] [FILE|DIR]" << std::endl;
 	std::cerr << "Description: Convert input Jack file to XML." << std::endl;
-	std::cerr << "             If directory, convert each Jack file in it to a separate XML file.";
+	std::cerr << "             If directory, convert each Jack file in it to a separate XML file." << std::endl;
+	std::cerr << "             With -j, analyze up to N files at a time." << std::endl;
+	std::cerr << "             With --tokens, write only the tokens of each file, to a T.xml file." << std::endl;
+	std::cerr << "             With --check, write no XML and only report the files that do not parse.";
 	std::cerr << std::endl;
 }
@@ -0,0 +1,57 @@
+#include <charconv>			// std::to_chars
+#include <fstream>
+#include "XmlWriter.h"
+
+// Initial buffer capacity; enough for the XML of most classes.
+static const size_t BUFFER_RESERVE = 256 * 1024;
+
+// In the order of JackTokenType.
+const std::string_view XmlWriter::s_OPEN_TAGS[] = {
+	"<keyword> ", "<symbol> ", "<identifier> ", "<integerConstant> ", "<stringConstant> ", "<invalid> "
+};
+const std::string_view XmlWriter::s_CLOSE_TAGS[] = {
+	" </keyword>\n", " </symbol>\n", " </identifier>\n", " </integerConstant>\n", " </stringConstant>\n", " </invalid>\n"
+};
+
+XmlWriter::XmlWriter(bool enabled)
+	:m_Enabled{ enabled }
+{
+	if (m_Enabled)
+		m_Buffer.reserve(BUFFER_RESERVE);
+}
+
+void XmlWriter::WriteTerminal(JackTokenType type, std::string_view text)
+{
+	if (!m_Enabled)
+		return;
+	m_Buffer.append(s_OPEN_TAGS[static_cast<int>(type)]);
+	AppendEscaped(text);
+	m_Buffer.append(s_CLOSE_TAGS[static_cast<int>(type)]);
+}
+
+void XmlWriter::WriteTerminal(int intVal)
+{
+	if (!m_Enabled)
+		return;
+	char digits[16];
+	const auto result = std::to_chars(std::begin(digits), std::end(digits), intVal);
+	WriteTerminal(JackTokenType::INT_CONST, std::string_view(digits, result.ptr - digits));
+}
+
+void XmlWriter::AppendEscaped(std::string_view text)
+{
+	for (size_t special; (special = text.find_first_of("<>&")) != std::string_view::npos; )
+	{
+		m_Buffer.append(text.substr(0, special));
+		m_Buffer.append(text[special] == '<' ? "&lt;" : text[special] == '>' ? "&gt;" : "&amp;");
+		text.remove_prefix(special + 1);
+	}
+	m_Buffer.append(text);
+}
+
+bool XmlWriter::Save(const std::filesystem::path& path) const
+{
+	std::ofstream ofs{ path };
+	ofs.write(m_Buffer.data(), m_Buffer.size());
+	return static_cast<bool>(ofs);
+}
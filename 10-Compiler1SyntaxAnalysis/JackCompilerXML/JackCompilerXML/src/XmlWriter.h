@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include "JackTokenizer.h"
+
+/*
+* Buffers the XML written for a Jack class in memory, to be saved to a file
+* in one go. Markup is appended as whole string literals, and terminals
+* between their tags, which are looked up by token type. A disabled writer
+* discards everything, for when the analyzer is only asked for a verdict.
+*/
+class XmlWriter
+{
+private:
+	// Opening and closing tags of each token type, with their spacing.
+	static const std::string_view s_OPEN_TAGS[];
+	static const std::string_view s_CLOSE_TAGS[];
+
+	bool m_Enabled;
+	std::string m_Buffer;
+
+	// Appends text with <, > and & escaped, copying the runs between them whole.
+	void AppendEscaped(std::string_view text);
+public:
+	XmlWriter(bool enabled = true);
+	// Appends markup as is, e.g. "<statements>\n".
+	void Write(std::string_view markup)
+	{
+		if (m_Enabled)
+			m_Buffer.append(markup);
+	}
+	// Appends a terminal element, e.g. "<keyword> class </keyword>\n".
+	void WriteTerminal(JackTokenType type, std::string_view text);
+	void WriteTerminal(int intVal);
+	const std::string& Output() const { return m_Buffer; }
+	// Returns whether the file could be written.
+	bool Save(const std::filesystem::path& path) const;
+};
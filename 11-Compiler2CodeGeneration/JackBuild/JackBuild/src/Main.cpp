@@ -0,0 +1,202 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include "Pipeline.h"
+#include "../../../../06-Assembler/HackAssembler/HackAssembler/src/Assembler.h"
+#include "../../../JackCompiler/JackCompiler/src/CompilationEngine.h"
+#include "../../../JackCompiler/JackCompiler/src/Profile.h"
+
+namespace fs = std::filesystem;
+
+// Extensions the VM translator's CodeWriter expects to be defined.
+const std::string g_SRC_EXT = ".vm";
+const std::string g_TARGET_EXT = ".asm";
+
+void Usage(const std::string& programName);
+
+/*
+* Build a Jack program into Hack machine code in one process
+*
+* Input:	A directory of Jack files (.jack extension), optionally preceded
+*			by the compiler's -O0, --pool-strings and --extended-vm, by
+*			--profile FILE to optimize both the compiler's and the VM
+*			translator's code for a profiled run, by the translator's
+*			--static-frames, by -s to write a
+*			symbol map, and by --keep-vm and --keep-asm to also write
+*			the intermediate code
+* Output:	A Hack file (.hack extension) named after the directory, in
+*			current directory, unless the program is too large for the
+*			32K words of ROM
+*/
+int main(int argc, char* argv[])
+{
+	const std::string program_name = fs::path(argv[0]).stem().string();
+	jack::CompilerOptions options;
+	bool static_frames = false, write_symbols = false, keep_vm = false, keep_asm = false;
+	std::string profile_path;
+	int arg = 1;
+	for (; arg < argc && argv[arg][0] == '-'; arg++)
+	{
+		const std::string option = argv[arg];
+		if (option == "-O0")
+			options.optimize = false;
+		else if (option == "--pool-strings")
+			options.poolStrings = true;
+		else if (option == "--extended-vm")
+			options.extendedVM = true;
+		else if (option == "--profile" && arg + 1 < argc)
+			profile_path = argv[++arg];
+		else if (option == "--static-frames")
+			static_frames = true;
+		else if (option == "-s")
+			write_symbols = true;
+		else if (option == "--keep-vm")
+			keep_vm = true;
+		else if (option == "--keep-asm")
+			keep_asm = true;
+		else
+			break;
+	}
+	if (arg + 1 != argc || !fs::is_directory(argv[arg]))
+	{
+		Usage(program_name);
+		return EXIT_FAILURE;
+	}
+	const fs::path prgm_path = fs::absolute(argv[arg]);
+	std::string program_name_out = prgm_path.filename().string();
+	if (program_name_out.empty())		// "C:\ProgramDir\"
+		program_name_out = prgm_path.parent_path().filename().string();
+	std::vector<fs::path> abs_file_paths;
+	for (auto& f : fs::directory_iterator{ prgm_path })
+		if (f.is_regular_file() && f.path().extension() == ".jack")
+			abs_file_paths.emplace_back(f);
+	// Classes are laid out in ROM in name order, whatever order the directory lists them in.
+	std::sort(abs_file_paths.begin(), abs_file_paths.end());
+	std::string stage;
+	try
+	{
+		std::optional<jack::Profile> profile;
+		if (!profile_path.empty())
+		{
+			stage = profile_path;
+			profile.emplace(profile_path);
+			options.profile = &*profile;
+		}
+		// Class names and sources; the compiler chooses its hot functions from the whole program
+		std::vector<std::pair<std::string, std::string>> classes;
+		for (const fs::path& p : abs_file_paths)
+		{
+			stage = p.string();
+			std::ifstream ifs{ stage, std::ios::binary };
+			if (!ifs)
+				throw std::ifstream::failure("Problem encountered while opening \"" + stage + "\"");
+			std::ostringstream source;
+			source << ifs.rdbuf();
+			classes.emplace_back(p.stem().string(), source.str());
+		}
+		if (profile)
+		{
+			stage = profile_path;
+			profile->ChooseHot(classes, options);
+		}
+		// Static frames and the translator's hot functions need the whole program, so its classes are all compiled first
+		std::vector<std::string> vm_code;
+		for (size_t i = 0; i < classes.size(); i++)
+		{
+			stage = abs_file_paths[i].string();
+			std::cout << "Processing " << stage << std::endl;
+			jack::CompilationEngine engine{ classes[i].second, classes[i].first, options };
+			engine.CompileClass();
+			if (keep_vm)
+				std::ofstream{ classes[i].first + g_SRC_EXT } << engine.Output();
+			vm_code.push_back(engine.Output());
+		}
+		std::unordered_map<std::string, int> frames;
+		if (static_frames)
+		{
+			CallGraph graph;
+			for (size_t i = 0; i < classes.size(); i++)
+				build::AnalyzeVM(vm_code[i], classes[i].first, graph);
+			frames = graph.StaticFrames();
+		}
+		// Translates the whole program with writer
+		auto translate = [&](CodeWriter& writer) {
+			writer.SetStaticFrames(frames);
+			writer.WriteInit();
+			for (size_t i = 0; i < classes.size(); i++)
+			{
+				stage = abs_file_paths[i].string();
+				build::TranslateVM(vm_code[i], classes[i].first, writer);
+			}
+			writer.WriteRoutines();
+		};
+		std::stringstream assembly;
+		size_t words;
+		{
+			CodeWriter writer{ assembly };
+			if (profile)
+			{	// The program translated with every function cold and hot, only to count their words
+				std::ostream discard{ nullptr };
+				CodeWriter cold{ discard }, hot{ discard };
+				cold.LoadProfile(profile_path);
+				translate(cold);
+				translate(hot);
+				writer.LoadProfile(profile_path);
+				writer.ChooseHotFunctions(cold, hot);
+			}
+			translate(writer);
+			words = writer.Words();
+		}
+		if (keep_asm)
+			std::ofstream{ program_name_out + g_TARGET_EXT } << assembly.str();
+		stage = program_name_out + g_TARGET_EXT;
+		if (words > CodeWriter::ROM_WORDS)
+			throw std::length_error(std::to_string(words) + " instructions, more than the " +
+				std::to_string(CodeWriter::ROM_WORDS) + " words of ROM");
+		Hack::Parser asm_parser{ assembly };
+		Hack::Assembler assembler;
+		std::ostringstream hack;
+		assembler.Assemble(asm_parser, hack);
+		std::ofstream ofs{ program_name_out + ".hack" };
+		if (!ofs)
+			throw std::ofstream::failure("Problem encountered while creating \"" + program_name_out + ".hack\"");
+		ofs << hack.str();
+		if (write_symbols)
+		{	// Symbol map with one "ADDRESS LABEL" line per label, in program order
+			std::ofstream sym{ program_name_out + ".sym" };
+			for (const auto& [address, label] : assembler.Symbols().Labels())
+				sym << address << " " << label << "\n";
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << stage << ": " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+/*
+* On invalid command-line arguments, gives user usage information.
+*/
+void Usage(const std::string& programName)
+{
+	std::cerr << "Usage: " << programName << " [-O0] [--pool-strings] [--extended-vm] [--profile FILE] [--static-frames] [-s] [--keep-vm] [--keep-asm] DIR" << std::endl;
+	std::cerr << "Description: Compile, translate and assemble the Jack files in DIR to DIR.hack." << std::endl;
+	std::cerr << "             -O0, --pool-strings and --extended-vm are passed to the compiler." << std::endl;
+	std::cerr << "             --profile is passed to both the compiler and the VM translator." << std::endl;
+	std::cerr << "             --static-frames is passed to the VM translator." << std::endl;
+	std::cerr << "             Fail, writing no DIR.hack, if the program does not fit in the 32K words of ROM." << std::endl;
+	std::cerr << "             With -s, also write a symbol map (DIR.sym) of each label's ROM address." << std::endl;
+	std::cerr << "             With --keep-vm and --keep-asm, also write the VM and assembly code.";
+	std::cerr << std::endl;
+}
@@ -0,0 +1,29 @@
+#include <sstream>
+#include "Pipeline.h"
+#include "../../../../08-VM2ProgramControl/HackVMTranslator/HackVMTranslator/src/Parser.h"
+
+namespace build {
+void AnalyzeVM(std::string_view vm, const std::string& className, CallGraph& graph)
+{
+	std::istringstream iss{ std::string(vm) };
+	Parser parser{ iss, className };
+	graph.SetFileName(className);
+	while (parser.HasMoreCommands())
+	{
+		parser.Advance();
+		graph.AddCommand(parser.Command(), parser.Arg1(), parser.Arg2(), parser.Arg3(), parser.Arg4());
+	}
+}
+
+void TranslateVM(std::string_view vm, const std::string& className, CodeWriter& writer)
+{
+	std::istringstream iss{ std::string(vm) };
+	Parser parser{ iss, className };
+	writer.SetFileName(className);
+	while (parser.HasMoreCommands())
+	{
+		parser.Advance();
+		writer.WriteCommand(parser);
+	}
+}
+} // namespace build
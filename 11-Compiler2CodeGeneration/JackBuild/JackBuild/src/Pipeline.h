@@ -0,0 +1,18 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include "../../../../08-VM2ProgramControl/HackVMTranslator/HackVMTranslator/src/CallGraph.h"
+#include "../../../../08-VM2ProgramControl/HackVMTranslator/HackVMTranslator/src/CodeWriter.h"
+
+/*
+* The stages of a build after compilation, run on code held in memory
+* rather than on files: VM code of a class is read by the VM translator's
+* Parser and fed command by command to its CodeWriter, and the Hack
+* assembly written is assembled by the assembler's Assembler.
+*/
+namespace build {
+// Adds the VM code of one class, whose file name is className, to graph.
+void AnalyzeVM(std::string_view vm, const std::string& className, CallGraph& graph);
+// Translates the VM code of one class, whose file name is className, with writer.
+void TranslateVM(std::string_view vm, const std::string& className, CodeWriter& writer);
+} // namespace build
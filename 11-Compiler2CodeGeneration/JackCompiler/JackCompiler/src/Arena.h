@@ -0,0 +1,95 @@
+#pragma once
+#include <algorithm>		// std::copy, std::max
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jack {
+/*
+* A fixed-size run of values allocated in an Arena, such as the statements
+* of a block or the arguments of a call.
+*/
+template <class T>
+struct ArenaList
+{
+	T* items = nullptr;
+	size_t size = 0;
+
+	T* begin() const { return items; }
+	T* end() const { return items + size; }
+	bool empty() const { return size == 0; }
+	T& operator[](size_t i) const { return items[i]; }
+};
+
+/*
+* Allocates objects out of large blocks that are all freed together when
+* the arena is destroyed, so building a tree of many small nodes costs
+* little more than bumping a pointer. Only trivially destructible types
+* may be allocated, as no destructors are run.
+*/
+class Arena
+{
+public:
+	Arena() : m_Next{ nullptr }, m_Left{ 0 } {}
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	template <class T, class... Args>
+	T* New(Args&&... args)
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "Arena does not run destructors");
+		return new (Allocate(sizeof(T), alignof(T))) T{ std::forward<Args>(args)... };
+	}
+
+	// Copies values into the arena.
+	template <class T>
+	ArenaList<T> List(const std::vector<T>& values)
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "Arena does not run destructors");
+		ArenaList<T> list;
+		if (values.empty())
+			return list;
+		list.items = static_cast<T*>(Allocate(sizeof(T) * values.size(), alignof(T)));
+		for (size_t i = 0; i < values.size(); i++)
+			new (&list.items[i]) T(values[i]);
+		list.size = values.size();
+		return list;
+	}
+
+	// Copies text into the arena, for names built while parsing.
+	std::string_view Copy(std::string_view text)
+	{
+		char* chars = static_cast<char*>(Allocate(text.size(), 1));
+		std::copy(text.begin(), text.end(), chars);
+		return { chars, text.size() };
+	}
+private:
+	static const size_t BLOCK_SIZE = 64 * 1024;
+
+	std::vector<std::unique_ptr<std::byte[]>> m_Blocks;
+	std::byte* m_Next;
+	size_t m_Left;
+
+	void* Allocate(size_t size, size_t align)
+	{
+		size_t padding = (align - reinterpret_cast<uintptr_t>(m_Next) % align) % align;
+		if (size + padding > m_Left)
+		{	// Objects larger than a block get a block of their own.
+			size_t block_size = std::max(BLOCK_SIZE, size + align);
+			m_Blocks.push_back(std::make_unique<std::byte[]>(block_size));
+			m_Next = m_Blocks.back().get();
+			m_Left = block_size;
+			padding = (align - reinterpret_cast<uintptr_t>(m_Next) % align) % align;
+		}
+		void* p = m_Next + padding;
+		m_Next += padding + size;
+		m_Left -= padding + size;
+		return p;
+	}
+};
+} // namespace jack
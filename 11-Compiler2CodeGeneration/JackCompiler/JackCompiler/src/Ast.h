@@ -0,0 +1,103 @@
+#pragma once
+#include <string_view>
+#include "Arena.h"
+#include "JackTokenizer.h"
+#include "VMWriter.h"
+
+namespace jack {
+/*
+* Abstract syntax tree of a Jack class, built by the CompilationEngine in
+* an Arena. Names have already been resolved, so each variable carries
+* its VM segment and index, and each call the full name of the subroutine
+* it calls. Nodes are rewritten in place by the Optimizer's passes before
+* the CodeGenerator walks them.
+*/
+namespace ast {
+// A variable as the VM sees it.
+struct Var
+{
+	VMWriter::Segment segment;
+	int index;
+
+	bool operator==(const Var& other) const { return segment == other.segment && index == other.index; }
+	bool operator!=(const Var& other) const { return !(*this == other); }
+};
+
+enum class ExprKind
+{
+	INT,		// value; may be negative once folded
+	STRING,		// text
+	TRUE, FALSE, J_NULL, THIS,
+	VAR,		// var
+	INDEX,		// var[left]
+	CALL,		// text(left, args...) where left, if any, is the object called on
+	UNARY,		// op left
+	BINARY		// left op right
+};
+
+struct Expr
+{
+	ExprKind kind;
+	int value;
+	char op;
+	std::string_view text;
+	Var var;
+	Expr* left;
+	Expr* right;
+	ArenaList<Expr*> args;
+	// INDEX only: THAT already points at the element, so it need not be computed.
+	bool reuseThat;
+};
+
+enum class StmtKind
+{
+	LET,		// var = expr, or var[index] = expr
+	IF,			// if (expr) body else elseBody
+	WHILE,		// while (expr) body
+	DO,			// expr is the call
+	RETURN		// expr, or nullptr for none
+};
+
+struct Stmt
+{
+	StmtKind kind;
+	Var var;
+	Expr* index;
+	Expr* expr;
+	ArenaList<Stmt*> body;
+	ArenaList<Stmt*> elseBody;
+};
+
+struct Subroutine
+{
+	// FUNCTION, METHOD or CONSTRUCTOR.
+	JackKeyWord kind;
+	// Full VM name, e.g. "Main.main".
+	std::string_view name;
+	int nLocals;
+	// Number of arguments, including "this" for methods.
+	int nArgs;
+	// Number of fields, for constructors to allocate the object.
+	int nFields;
+	ArenaList<Stmt*> body;
+};
+
+// Whether expr contains a call, the only kind of expression with side effects.
+inline bool HasCall(const Expr* expr)
+{
+	if (!expr)
+		return false;
+	if (expr->kind == ExprKind::CALL)
+		return true;
+	return HasCall(expr->left) || HasCall(expr->right);
+}
+
+struct Class
+{
+	std::string_view name;
+	// Number of static variables the class declares.
+	int nStatics;
+	ArenaList<Subroutine*> subroutines;
+};
+} // namespace ast
+} // namespace jack
@@ -0,0 +1,70 @@
+#include <fstream>
+#include <sstream>
+#include "BuildCache.h"
+#include "CompilerOptions.h"
+
+namespace jack {
+// Reads the whole file at path into text; returns whether it could.
+static bool ReadFile(const std::string& path, std::string& text)
+{
+	std::ifstream ifs{ path, std::ios::binary };
+	if (!ifs)
+		return false;
+	std::ostringstream oss;
+	oss << ifs.rdbuf();
+	text = oss.str();
+	return true;
+}
+
+BuildCache::BuildCache(const std::string& path, const std::string& options)
+	:m_Path{ path }, m_Header{ "jackcache " + std::to_string(CompilerOptions::CODE_VERSION) + " " + options }
+{
+	std::ifstream ifs{ path };
+	std::string line;
+	if (!std::getline(ifs, line) || line != m_Header)
+		return;
+	while (std::getline(ifs, line))
+	{
+		std::istringstream iss{ line };
+		Entry entry;
+		std::string class_name;
+		if (iss >> std::hex >> entry.sourceHash >> entry.vmHash >> class_name)
+			m_Entries[class_name] = entry;
+	}
+}
+
+bool BuildCache::IsFresh(const std::string& className, std::string_view source, const std::string& vmPath) const
+{
+	auto it = m_Entries.find(className);
+	if (it == m_Entries.end() || it->second.sourceHash != Hash(source))
+		return false;
+	// The VM file may have been deleted or edited since.
+	std::string vm;
+	return ReadFile(vmPath, vm) && it->second.vmHash == Hash(vm);
+}
+
+void BuildCache::Update(const std::string& className, std::string_view source, std::string_view vm)
+{
+	m_Entries[className] = { Hash(source), Hash(vm) };
+}
+
+bool BuildCache::Save() const
+{
+	std::ofstream ofs{ m_Path };
+	ofs << m_Header << "\n" << std::hex;
+	for (const auto& entry : m_Entries)
+		ofs << entry.second.sourceHash << " " << entry.second.vmHash << " " << entry.first << "\n";
+	return static_cast<bool>(ofs);
+}
+
+uint64_t BuildCache::Hash(std::string_view data)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (char c : data)
+	{
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+} // namespace jack
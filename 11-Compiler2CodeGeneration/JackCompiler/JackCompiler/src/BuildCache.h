@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+
+namespace jack {
+/*
+* Remembers, across runs, the source each class's VM file was compiled
+* from, so that classes whose source has not changed need not be compiled
+* again. The cache file holds a header with the compiler's CODE_VERSION and
+* the options the classes were compiled with, then one line per class:
+*
+*	SOURCE_HASH VM_HASH CLASS
+*
+* with 64-bit FNV-1a hashes of the Jack source and of the VM file written
+* for it. The VM code of a class depends on nothing but its own source and
+* the options: calls to other classes are compiled from the call alone.
+* So no class has to be recompiled because another one changed, unless
+* that changes the hot functions chosen with a profile, which are part of
+* the options.
+*/
+class BuildCache
+{
+public:
+	// Loads the cache at path, unless it is missing or was written for another code version or other options.
+	BuildCache(const std::string& path, const std::string& options);
+	// Whether vmPath still holds the code compiled for className from source.
+	bool IsFresh(const std::string& className, std::string_view source, const std::string& vmPath) const;
+	void Update(const std::string& className, std::string_view source, std::string_view vm);
+	void Erase(const std::string& className) { m_Entries.erase(className); }
+	// Returns whether the cache file could be written.
+	bool Save() const;
+	static uint64_t Hash(std::string_view data);
+private:
+	struct Entry
+	{
+		uint64_t sourceHash;
+		uint64_t vmHash;
+	};
+	std::string m_Path;
+	std::string m_Header;
+	std::map<std::string, Entry> m_Entries;
+};
+} // namespace jack
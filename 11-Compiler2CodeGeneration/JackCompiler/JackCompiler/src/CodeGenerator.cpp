@@ -0,0 +1,761 @@
+#include "CodeGenerator.h"
+#include "Profile.h"
+
+namespace jack {
+// Whether expr is always true (-1) or false (0), so that jumping when it is nonzero is jumping when it is true.
+static bool IsBoolean(const ast::Expr& expr)
+{
+	switch (expr.kind)
+	{
+	case ast::ExprKind::TRUE:
+	case ast::ExprKind::FALSE:
+		return true;
+	case ast::ExprKind::INT:
+		return expr.value == 0 || expr.value == -1;
+	case ast::ExprKind::UNARY:
+		return expr.op == '~' && IsBoolean(*expr.left);
+	case ast::ExprKind::BINARY:
+		if (expr.op == '<' || expr.op == '>' || expr.op == '=')
+			return true;
+		return (expr.op == '&' || expr.op == '|') && IsBoolean(*expr.left) && IsBoolean(*expr.right);
+	default:
+		return false;
+	}
+}
+
+static bool IsVar(const ast::Expr& expr, const ast::Var& var)
+{
+	return expr.kind == ast::ExprKind::VAR && expr.var == var;
+}
+
+static bool IsInt(const ast::Expr& expr, int value)
+{
+	return expr.kind == ast::ExprKind::INT && expr.value == value;
+}
+
+const int CodeGenerator::s_MAX_MULTIPLY_STEPS = 10;
+const int CodeGenerator::s_MAX_COLD_MULTIPLY_STEPS = 1;
+const char* const CodeGenerator::s_HALVE = "__halve";
+const char* const CodeGenerator::s_TAIL_CALL = "TAIL_CALL";
+
+CodeGenerator::CodeGenerator(VMWriter& writer, const CompilerOptions& options)
+	:m_Writer{ writer }, m_Options{ options }, m_LabelCount{ 0 }, m_UsesHalve{ false },
+	m_NextStringSlot{ 0 }, m_Sub{ nullptr },
+	m_ThatLive{ false }
+{}
+
+void CodeGenerator::Generate(const ast::Class& cls)
+{
+	m_ClassName = cls.name;
+	m_NextStringSlot = cls.nStatics;
+	for (const ast::Subroutine* sub : cls.subroutines)
+		GenerateSubroutine(*sub);
+	if (m_UsesHalve)
+		GenerateHalvingHelper();
+}
+
+void CodeGenerator::GenerateSubroutine(const ast::Subroutine& sub)
+{
+	m_Sub = &sub;
+	m_Writer.WriteFunction(sub.name, sub.nLocals);
+	if (sub.kind == JackKeyWord::METHOD)
+	{	// First argument is "this"; set its base address in current scope.
+		m_Writer.WritePush(VMWriter::Segment::ARG, 0);
+		m_Writer.WritePop(VMWriter::Segment::POINTER, 0);
+	}
+	else if (sub.kind == JackKeyWord::CONSTRUCTOR)
+	{	// Allocate memory for object.
+		m_Writer.WritePush(VMWriter::Segment::CONST, sub.nFields);
+		m_Writer.WriteCall("Memory.alloc", 1);	// Returns base address of object created.
+		m_Writer.WritePop(VMWriter::Segment::POINTER, 0);	// Set "this" to that base address.
+	}
+	if (m_Options.optimize && HasSelfTailCall(sub.body))
+		m_Writer.WriteLabel(s_TAIL_CALL);
+	GenerateStatements(sub.body);
+}
+
+/*
+* A function calling itself, or a method calling itself on the same
+* object, with as many arguments as it takes. Constructors allocate a new
+* object on each call, so they are left alone.
+*/
+bool CodeGenerator::IsSelfTailCall(const ast::Expr* expr) const
+{
+	if (!m_Options.optimize || !expr || expr->kind != ast::ExprKind::CALL || expr->text != m_Sub->name)
+		return false;
+	if (m_Sub->kind == JackKeyWord::FUNCTION)
+		return !expr->left && static_cast<int>(expr->args.size) == m_Sub->nArgs;
+	if (m_Sub->kind == JackKeyWord::METHOD)
+		return expr->left && expr->left->kind == ast::ExprKind::THIS &&
+			static_cast<int>(expr->args.size) + 1 == m_Sub->nArgs;
+	return false;
+}
+
+bool CodeGenerator::IsCold() const
+{
+	return m_Options.profile && !m_Options.profile->IsHot(m_Sub->name);
+}
+
+bool CodeGenerator::HasSelfTailCall(const ArenaList<ast::Stmt*>& statements) const
+{
+	for (const ast::Stmt* stmt : statements)
+	{
+		if (stmt->kind == ast::StmtKind::RETURN && IsSelfTailCall(stmt->expr))
+			return true;
+		if (HasSelfTailCall(stmt->body) || HasSelfTailCall(stmt->elseBody))
+			return true;
+	}
+	return false;
+}
+
+/*
+* All new arguments are computed before any is assigned, as they may read
+* the old ones. Locals start at 0 on every call, so they are cleared too;
+* a method's "this" stays as it is.
+*/
+void CodeGenerator::GenerateSelfTailCall(const ast::Expr& call)
+{
+	const int first = (m_Sub->kind == JackKeyWord::METHOD) ? 1 : 0;
+	for (const ast::Expr* arg : call.args)
+		GenerateExpression(*arg);
+	for (int i = m_Sub->nArgs - 1; i >= first; i--)
+		m_Writer.WritePop(VMWriter::Segment::ARG, i);
+	for (int i = 0; i < m_Sub->nLocals; i++)
+	{
+		m_Writer.WritePush(VMWriter::Segment::CONST, 0);
+		m_Writer.WritePop(VMWriter::Segment::LOCAL, i);
+	}
+	m_Writer.WriteGoto(s_TAIL_CALL);
+}
+
+void CodeGenerator::GenerateStatements(const ArenaList<ast::Stmt*>& statements)
+{
+	for (const ast::Stmt* stmt : statements)
+	{
+		switch (stmt->kind)
+		{
+		case ast::StmtKind::LET:
+			GenerateLet(*stmt);
+			break;
+		case ast::StmtKind::IF:
+			GenerateIf(*stmt);
+			break;
+		case ast::StmtKind::WHILE:
+			GenerateWhile(*stmt);
+			break;
+		case ast::StmtKind::DO:
+			if (m_Options.optimize && GeneratePoke(*stmt->expr))
+				break;
+			GenerateCall(*stmt->expr);
+			m_Writer.WritePop(VMWriter::Segment::TEMP, 0);	// Ignore return value.
+			break;
+		case ast::StmtKind::RETURN:
+			if (IsSelfTailCall(stmt->expr))
+			{
+				GenerateSelfTailCall(*stmt->expr);
+				break;
+			}
+			if (stmt->expr)
+				GenerateExpression(*stmt->expr);
+			else // Empty return statement; push 0.
+				m_Writer.WritePush(VMWriter::Segment::CONST, 0);
+			m_Writer.WriteReturn();
+			break;
+		}
+	}
+}
+
+/* Example 1: let x = 5 * 8;
+* Example 2: let a[i] = 2 * a[i-1];
+*/
+void CodeGenerator::GenerateLet(const ast::Stmt& stmt)
+{
+	if (stmt.index)
+	{	// THAT is set before the value is computed; reading other arrays in it preserves THAT.
+		GenerateArrayOffset(stmt.var, *stmt.index);
+		m_ThatLive = true;
+		GenerateExpression(*stmt.expr);
+		m_ThatLive = false;
+		m_Writer.WritePop(VMWriter::Segment::THAT, 0);
+	}
+	else if (!m_Options.optimize || !m_Options.extendedVM || !GenerateFusedLet(stmt.var, *stmt.expr))
+	{
+		GenerateExpression(*stmt.expr);
+		m_Writer.WritePop(stmt.var.segment, stmt.var.index);
+	}
+}
+
+bool CodeGenerator::GenerateFusedLet(const ast::Var& var, const ast::Expr& value)
+{
+	if (value.kind == ast::ExprKind::VAR)
+		m_Writer.WriteMove(value.var.segment, value.var.index, var.segment, var.index);
+	else if (value.kind == ast::ExprKind::INT && value.value >= 0)
+		m_Writer.WriteMove(VMWriter::Segment::CONST, value.value, var.segment, var.index);
+	else if (value.kind != ast::ExprKind::BINARY || (value.op != '+' && value.op != '-'))
+		return false;
+	else if (IsVar(*value.left, var) && IsInt(*value.right, 1))
+	{
+		if (value.op == '+')
+			m_Writer.WriteInc(var.segment, var.index);
+		else
+			m_Writer.WriteDec(var.segment, var.index);
+	}
+	else if (value.op == '+' && IsInt(*value.left, 1) && IsVar(*value.right, var))
+		m_Writer.WriteInc(var.segment, var.index);
+	else
+		return false;
+	return true;
+}
+
+/*
+* Number of "not" commands GenerateBranch writes for cond, when optimizing
+* without the extended VM, whose comparisons never need one.
+*/
+static int CountNots(const ast::Expr& cond, bool jumpIfTrue)
+{
+	if (cond.kind == ast::ExprKind::UNARY && IsBoolean(cond))
+		return CountNots(*cond.left, !jumpIfTrue);
+	if (cond.kind == ast::ExprKind::BINARY && (cond.op == '&' || cond.op == '|') &&
+		IsBoolean(cond) && !ast::HasCall(cond.right))
+	{
+		const bool decides = (cond.op == '|');
+		return CountNots(*cond.left, jumpIfTrue == decides ? jumpIfTrue : decides) +
+			CountNots(*cond.right, jumpIfTrue);
+	}
+	return jumpIfTrue ? 0 : 1;
+}
+
+/*
+* The condition normally jumps to the else part when false. A boolean one
+* whose jumps take fewer "not"s when it jumps on true jumps to the body
+* instead, with the else part laid out first:
+*
+*	(jump to IF_TRUEn if the condition is true)
+*	(else body)
+*	goto END_IFn
+*	label IF_TRUEn
+*	(body)
+*	label END_IFn
+*/
+void CodeGenerator::GenerateIf(const ast::Stmt& stmt)
+{
+	const std::string else_label = std::string("ELSE") + std::to_string(m_LabelCount);
+	const std::string end_if_label = std::string("END_IF") + std::to_string(m_LabelCount);
+	const std::string if_true_label = std::string("IF_TRUE") + std::to_string(m_LabelCount);
+	m_LabelCount++;
+	if (m_Options.optimize && !m_Options.extendedVM && IsBoolean(*stmt.expr) &&
+		CountNots(*stmt.expr, true) < CountNots(*stmt.expr, false))
+	{
+		GenerateBranch(*stmt.expr, if_true_label, true);
+		GenerateStatements(stmt.elseBody);
+		m_Writer.WriteGoto(end_if_label);
+		m_Writer.WriteLabel(if_true_label);
+		GenerateStatements(stmt.body);
+		m_Writer.WriteLabel(end_if_label);
+		return;
+	}
+	GenerateBranch(*stmt.expr, else_label, false);
+	GenerateStatements(stmt.body);
+	if (!stmt.elseBody.empty() || !m_Options.optimize)
+		m_Writer.WriteGoto(end_if_label);
+	m_Writer.WriteLabel(else_label);
+	GenerateStatements(stmt.elseBody);
+	m_Writer.WriteLabel(end_if_label);
+}
+
+/*
+* A loop whose condition is boolean tests it at the bottom, so that each
+* iteration takes a single jump:
+*
+*	goto WHILE_RETRYn
+*	label WHILE_BODYn
+*	(body)
+*	label WHILE_RETRYn
+*	(jump to WHILE_BODYn if the condition is true)
+*/
+void CodeGenerator::GenerateWhile(const ast::Stmt& stmt)
+{
+	const std::string end_while_label = std::string("END_WHILE") + std::to_string(m_LabelCount);
+	const std::string while_test_label = std::string("WHILE_RETRY") + std::to_string(m_LabelCount);
+	const std::string while_body_label = std::string("WHILE_BODY") + std::to_string(m_LabelCount);
+	m_LabelCount++;
+	if (m_Options.optimize && IsBoolean(*stmt.expr))
+	{
+		m_Writer.WriteGoto(while_test_label);
+		m_Writer.WriteLabel(while_body_label);
+		GenerateStatements(stmt.body);
+		m_Writer.WriteLabel(while_test_label);
+		GenerateBranch(*stmt.expr, while_body_label, true);
+		return;
+	}
+	m_Writer.WriteLabel(while_test_label);
+	GenerateBranch(*stmt.expr, end_while_label, false);
+	GenerateStatements(stmt.body);
+	m_Writer.WriteGoto(while_test_label);
+	m_Writer.WriteLabel(end_while_label);
+}
+
+/*
+* A body runs only when its condition is true (-1), so in general the
+* condition is computed and its "not" tested. jumpIfTrue is only asked
+* for boolean conditions, for which a nonzero value is true.
+*/
+void CodeGenerator::GenerateBranch(const ast::Expr& cond, const std::string& label, bool jumpIfTrue)
+{
+	if (m_Options.optimize)
+	{
+		if (cond.kind == ast::ExprKind::UNARY && IsBoolean(cond))
+		{
+			GenerateBranch(*cond.left, label, !jumpIfTrue);
+			return;
+		}
+		if (cond.kind == ast::ExprKind::BINARY && (cond.op == '&' || cond.op == '|') &&
+			IsBoolean(cond) && !ast::HasCall(cond.right))
+		{	// The right operand need not run once the left one decides, as it has no side effects.
+			const bool decides = (cond.op == '|');	// The value of the left operand that decides.
+			if (jumpIfTrue == decides)
+			{
+				GenerateBranch(*cond.left, label, jumpIfTrue);
+				GenerateBranch(*cond.right, label, jumpIfTrue);
+				return;
+			}
+			const std::string skip_label = std::string("SKIP") + std::to_string(m_LabelCount);
+			m_LabelCount++;
+			GenerateBranch(*cond.left, skip_label, decides);
+			GenerateBranch(*cond.right, label, jumpIfTrue);
+			m_Writer.WriteLabel(skip_label);
+			return;
+		}
+		if (m_Options.extendedVM && cond.kind == ast::ExprKind::BINARY &&
+			(cond.op == '<' || cond.op == '>' || cond.op == '='))
+		{
+			GenerateExpression(*cond.left);
+			GenerateExpression(*cond.right);
+			VMWriter::Comparison cmp;
+			if (cond.op == '<')
+				cmp = jumpIfTrue ? VMWriter::Comparison::LT : VMWriter::Comparison::GE;
+			else if (cond.op == '>')
+				cmp = jumpIfTrue ? VMWriter::Comparison::GT : VMWriter::Comparison::LE;
+			else
+				cmp = jumpIfTrue ? VMWriter::Comparison::EQ : VMWriter::Comparison::NE;
+			m_Writer.WriteIfCompare(cmp, label);
+			return;
+		}
+	}
+	GenerateExpression(cond);
+	if (!jumpIfTrue)
+		m_Writer.WriteArithmetic(VMWriter::Command::NOT);
+	m_Writer.WriteIf(label);
+}
+
+void CodeGenerator::GenerateExpression(const ast::Expr& expr)
+{
+	switch (expr.kind)
+	{
+	case ast::ExprKind::INT:
+		PushInt(expr.value);
+		break;
+	case ast::ExprKind::STRING:
+		if (m_Options.poolStrings)
+			GeneratePooledString(expr.text);
+		else
+			GenerateString(expr.text);
+		break;
+	case ast::ExprKind::TRUE:
+		m_Writer.WritePush(VMWriter::Segment::CONST, 1);
+		m_Writer.WriteArithmetic(VMWriter::Command::NEG);
+		break;
+	case ast::ExprKind::FALSE:
+	case ast::ExprKind::J_NULL:
+		m_Writer.WritePush(VMWriter::Segment::CONST, 0);
+		break;
+	case ast::ExprKind::THIS:
+		m_Writer.WritePush(VMWriter::Segment::POINTER, 0);
+		break;
+	case ast::ExprKind::VAR:
+		m_Writer.WritePush(expr.var.segment, expr.var.index);
+		break;
+	case ast::ExprKind::INDEX:
+		GenerateArrayRead(expr);
+		break;
+	case ast::ExprKind::CALL:
+		if (m_Options.optimize && GenerateIntrinsic(expr))
+			break;
+		GenerateCall(expr);
+		break;
+	case ast::ExprKind::UNARY:
+		GenerateExpression(*expr.left);
+		m_Writer.WriteArithmetic(expr.op == '~' ? VMWriter::Command::NOT : VMWriter::Command::NEG);
+		break;
+	case ast::ExprKind::BINARY:
+		if (m_Options.optimize)
+		{
+			const ast::Expr& l = *expr.left;
+			const ast::Expr& r = *expr.right;
+			if (expr.op == '*' && r.kind == ast::ExprKind::INT && GenerateMultiply(l, r.value))
+				break;
+			if (expr.op == '*' && l.kind == ast::ExprKind::INT && GenerateMultiply(r, l.value))
+				break;
+			if (expr.op == '/' && r.kind == ast::ExprKind::INT && GenerateDivide(l, r.value))
+				break;
+			if ((expr.op == '+' || expr.op == '-') && IsFusable(r))
+			{
+				GenerateExpression(l);
+				GenerateFusedArithmetic(expr.op == '+' ? VMWriter::Command::ADD : VMWriter::Command::SUB, r);
+				break;
+			}
+		}
+		GenerateExpression(*expr.left);
+		GenerateExpression(*expr.right);
+		switch (expr.op)
+		{
+		case '+': m_Writer.WriteArithmetic(VMWriter::Command::ADD); break;
+		case '-': m_Writer.WriteArithmetic(VMWriter::Command::SUB); break;
+		case '*': m_Writer.WriteCall("Math.multiply", 2); break;
+		case '/': m_Writer.WriteCall("Math.divide", 2); break;
+		case '&': m_Writer.WriteArithmetic(VMWriter::Command::AND); break;
+		case '|': m_Writer.WriteArithmetic(VMWriter::Command::OR); break;
+		case '>': m_Writer.WriteArithmetic(VMWriter::Command::GT); break;
+		case '<': m_Writer.WriteArithmetic(VMWriter::Command::LT); break;
+		case '=': m_Writer.WriteArithmetic(VMWriter::Command::EQ); break;
+		}
+		break;
+	}
+}
+
+/* The object a method is called on, if any, is its first argument. */
+void CodeGenerator::GenerateCall(const ast::Expr& call)
+{
+	int n_args = static_cast<int>(call.args.size);
+	if (call.left)
+	{
+		GenerateExpression(*call.left);
+		n_args++;
+	}
+	for (const ast::Expr* arg : call.args)
+		GenerateExpression(*arg);
+	m_Writer.WriteCall(call.text, n_args);
+}
+
+void CodeGenerator::GenerateArrayOffset(const ast::Var& var, const ast::Expr& index)
+{
+	m_Writer.WritePush(var.segment, var.index);		// Base address of array.
+	if (IsFusable(index))
+		GenerateFusedArithmetic(VMWriter::Command::ADD, index);
+	else
+	{
+		GenerateExpression(index);						// Compute array index, e.g. value 5.
+		m_Writer.WriteArithmetic(VMWriter::Command::ADD);	// E.g. a[5] or *(a+5).
+	}
+	m_Writer.WritePop(VMWriter::Segment::POINTER, 1);
+}
+
+bool CodeGenerator::IsFusable(const ast::Expr& operand) const
+{
+	return m_Options.optimize && m_Options.extendedVM &&
+		(operand.kind == ast::ExprKind::VAR || (operand.kind == ast::ExprKind::INT && operand.value >= 0));
+}
+
+void CodeGenerator::GenerateFusedArithmetic(VMWriter::Command cmd, const ast::Expr& operand)
+{
+	if (operand.kind == ast::ExprKind::VAR)
+		m_Writer.WritePushArithmetic(cmd, operand.var.segment, operand.var.index);
+	else
+		m_Writer.WritePushArithmetic(cmd, VMWriter::Segment::CONST, operand.value);
+}
+
+/*
+* Only a let's value needs THAT kept, and then only when optimizing; the
+* old THAT waits on the stack under the index, which may call anything:
+*
+*	push pointer 1
+*	(point THAT at the element)
+*	push that 0
+*	pop temp 0
+*	pop pointer 1
+*	push temp 0
+*/
+void CodeGenerator::GenerateArrayRead(const ast::Expr& expr)
+{
+	if (expr.reuseThat)
+	{	// THAT was pointed at this very element by the enclosing let.
+		m_Writer.WritePush(VMWriter::Segment::THAT, 0);
+		return;
+	}
+	GenerateRead([this, &expr]() { GenerateArrayOffset(expr.var, *expr.left); });
+}
+
+template <class Point>
+void CodeGenerator::GenerateRead(Point point)
+{
+	const bool save_that = m_ThatLive || !m_Options.optimize;
+	if (save_that)
+		m_Writer.WritePush(VMWriter::Segment::POINTER, 1);
+	// Reads in the index, as in a[b[i]], keep THAT too, for reads of the let's element.
+	point();
+	m_Writer.WritePush(VMWriter::Segment::THAT, 0);	// Push entry value.
+	if (save_that)
+	{	// Restore old "that" from under the value.
+		m_Writer.WritePop(VMWriter::Segment::TEMP, 0);
+		m_Writer.WritePop(VMWriter::Segment::POINTER, 1);
+		m_Writer.WritePush(VMWriter::Segment::TEMP, 0);
+	}
+}
+
+/*
+* Memory.peek reads through THAT as an array read does. Math.abs, max and
+* min branch around a neg, or a push of the other operand, which is kept
+* in temp 1 or temp 2; they compare the way the OS functions do.
+*/
+bool CodeGenerator::GenerateIntrinsic(const ast::Expr& call)
+{
+	if (call.left)
+		return false;
+	const size_t n_args = call.args.size;
+	if (call.text == "Memory.peek" && n_args == 1)
+	{
+		GenerateRead([this, &call]() {
+			GenerateExpression(*call.args[0]);
+			m_Writer.WritePop(VMWriter::Segment::POINTER, 1);
+		});
+		return true;
+	}
+	if (IsCold())
+		return false;	// The rest take more ROM than their calls.
+	if (call.text == "Math.abs" && n_args == 1)
+	{
+		const std::string positive_label = std::string("ABS_POSITIVE") + std::to_string(m_LabelCount);
+		m_LabelCount++;
+		GenerateExpression(*call.args[0]);
+		m_Writer.WritePop(VMWriter::Segment::TEMP, 1);
+		m_Writer.WritePush(VMWriter::Segment::TEMP, 1);
+		m_Writer.WritePush(VMWriter::Segment::TEMP, 1);
+		m_Writer.WritePush(VMWriter::Segment::CONST, 0);
+		m_Writer.WriteArithmetic(VMWriter::Command::LT);
+		m_Writer.WriteArithmetic(VMWriter::Command::NOT);
+		m_Writer.WriteIf(positive_label);
+		m_Writer.WriteArithmetic(VMWriter::Command::NEG);
+		m_Writer.WriteLabel(positive_label);
+		return true;
+	}
+	if ((call.text == "Math.max" || call.text == "Math.min") && n_args == 2)
+	{	// max is a if a > b, else b; min is a if a < b, else b.
+		const std::string first_label = std::string("PICK_FIRST") + std::to_string(m_LabelCount);
+		const std::string end_label = std::string("END_PICK") + std::to_string(m_LabelCount);
+		m_LabelCount++;
+		GenerateExpression(*call.args[0]);
+		GenerateExpression(*call.args[1]);
+		m_Writer.WritePop(VMWriter::Segment::TEMP, 2);
+		m_Writer.WritePop(VMWriter::Segment::TEMP, 1);
+		m_Writer.WritePush(VMWriter::Segment::TEMP, 1);
+		m_Writer.WritePush(VMWriter::Segment::TEMP, 2);
+		m_Writer.WriteArithmetic(call.text == "Math.max" ? VMWriter::Command::GT : VMWriter::Command::LT);
+		m_Writer.WriteIf(first_label);
+		m_Writer.WritePush(VMWriter::Segment::TEMP, 2);
+		m_Writer.WriteGoto(end_label);
+		m_Writer.WriteLabel(first_label);
+		m_Writer.WritePush(VMWriter::Segment::TEMP, 1);
+		m_Writer.WriteLabel(end_label);
+		return true;
+	}
+	return false;
+}
+
+// do Memory.poke(address, value), whose value is discarded anyway.
+bool CodeGenerator::GeneratePoke(const ast::Expr& call)
+{
+	if (call.left || call.text != "Memory.poke" || call.args.size != 2)
+		return false;
+	GenerateExpression(*call.args[0]);
+	GenerateExpression(*call.args[1]);
+	m_Writer.WritePop(VMWriter::Segment::TEMP, 0);
+	m_Writer.WritePop(VMWriter::Segment::POINTER, 1);
+	m_Writer.WritePush(VMWriter::Segment::TEMP, 0);
+	m_Writer.WritePop(VMWriter::Segment::THAT, 0);
+	return true;
+}
+
+/*
+* Computes x * c from the most significant bit of |c| down: each further
+* bit doubles the product so far, and adds x if the bit is set. x is kept
+* in temp 1 and temp 2 holds the product while it is doubled, e.g.
+* x * 5 = ((x + x) + (x + x)) + x.
+*/
+bool CodeGenerator::GenerateMultiply(const ast::Expr& x, int c)
+{
+	const int magnitude = (c < 0) ? -c : c;
+	if (magnitude == 0)
+	{	// x may still call something.
+		GenerateExpression(x);
+		m_Writer.WritePop(VMWriter::Segment::TEMP, 1);
+		m_Writer.WritePush(VMWriter::Segment::CONST, 0);
+		return true;
+	}
+	int top = 15;
+	while (!(magnitude & (1 << top)))
+		top--;
+	int steps = top;
+	for (int bit = 0; bit < top; bit++)
+		steps += (magnitude >> bit) & 1;
+	if (c == -32768 || steps > (IsCold() ? s_MAX_COLD_MULTIPLY_STEPS : s_MAX_MULTIPLY_STEPS))
+		return false;
+	GenerateExpression(x);
+	m_Writer.WritePop(VMWriter::Segment::TEMP, 1);
+	m_Writer.WritePush(VMWriter::Segment::TEMP, 1);
+	bool product_is_x = true;
+	for (int bit = top - 1; bit >= 0; bit--)
+	{
+		if (product_is_x)
+			m_Writer.WritePush(VMWriter::Segment::TEMP, 1);
+		else
+		{
+			m_Writer.WritePop(VMWriter::Segment::TEMP, 2);
+			m_Writer.WritePush(VMWriter::Segment::TEMP, 2);
+			m_Writer.WritePush(VMWriter::Segment::TEMP, 2);
+		}
+		m_Writer.WriteArithmetic(VMWriter::Command::ADD);
+		product_is_x = false;
+		if ((magnitude >> bit) & 1)
+		{
+			m_Writer.WritePush(VMWriter::Segment::TEMP, 1);
+			m_Writer.WriteArithmetic(VMWriter::Command::ADD);
+		}
+	}
+	if (c < 0)
+		m_Writer.WriteArithmetic(VMWriter::Command::NEG);
+	return true;
+}
+
+/*
+* Division by a power of two, or its negation, calls the class's halving
+* helper, which takes the bits of |x| from the divisor's up instead of
+* dividing recursively, and truncates toward zero as Math.divide does.
+*/
+bool CodeGenerator::GenerateDivide(const ast::Expr& x, int c)
+{
+	const int magnitude = (c < 0) ? -c : c;
+	if (c == -32768 || magnitude < 2 || (magnitude & (magnitude - 1)) != 0)
+		return false;
+	GenerateExpression(x);
+	m_Writer.WritePush(VMWriter::Segment::CONST, magnitude);
+	m_Writer.WriteCall(m_ClassName + "." + s_HALVE, 2);
+	if (c < 0)
+		m_Writer.WriteArithmetic(VMWriter::Command::NEG);
+	m_UsesHalve = true;
+	return true;
+}
+
+/*
+* function Class.__halve(x, mask), with mask a power of two, returns
+* x / mask. Locals: 0 the quotient, 1 the quotient bit of mask, 2 whether
+* x is negative. Doubling mask past bit 15 makes it 0, which ends the
+* loop; -32768 is handled by treating |x| as unsigned.
+*/
+void CodeGenerator::GenerateHalvingHelper()
+{
+	const VMWriter::Segment ARG = VMWriter::Segment::ARG;
+	const VMWriter::Segment LOCAL = VMWriter::Segment::LOCAL;
+	const VMWriter::Segment CONST = VMWriter::Segment::CONST;
+	m_Writer.WriteFunction(m_ClassName + "." + s_HALVE, 3);
+	m_Writer.WritePush(ARG, 0);
+	m_Writer.WritePush(CONST, 0);
+	m_Writer.WriteArithmetic(VMWriter::Command::LT);
+	m_Writer.WritePop(LOCAL, 2);
+	m_Writer.WritePush(LOCAL, 2);
+	m_Writer.WriteArithmetic(VMWriter::Command::NOT);
+	m_Writer.WriteIf("HALVE_LOOP_START");
+	m_Writer.WritePush(ARG, 0);						// x = |x|
+	m_Writer.WriteArithmetic(VMWriter::Command::NEG);
+	m_Writer.WritePop(ARG, 0);
+	m_Writer.WriteLabel("HALVE_LOOP_START");
+	m_Writer.WritePush(CONST, 1);
+	m_Writer.WritePop(LOCAL, 1);
+	m_Writer.WriteLabel("HALVE_LOOP");
+	m_Writer.WritePush(ARG, 1);
+	m_Writer.WritePush(CONST, 0);
+	m_Writer.WriteArithmetic(VMWriter::Command::EQ);
+	m_Writer.WriteIf("HALVE_END");
+	m_Writer.WritePush(ARG, 0);						// if (x & mask) quotient += bit
+	m_Writer.WritePush(ARG, 1);
+	m_Writer.WriteArithmetic(VMWriter::Command::AND);
+	m_Writer.WritePush(CONST, 0);
+	m_Writer.WriteArithmetic(VMWriter::Command::EQ);
+	m_Writer.WriteIf("HALVE_NEXT");
+	m_Writer.WritePush(LOCAL, 0);
+	m_Writer.WritePush(LOCAL, 1);
+	m_Writer.WriteArithmetic(VMWriter::Command::ADD);
+	m_Writer.WritePop(LOCAL, 0);
+	m_Writer.WriteLabel("HALVE_NEXT");
+	m_Writer.WritePush(ARG, 1);						// mask += mask; bit += bit
+	m_Writer.WritePush(ARG, 1);
+	m_Writer.WriteArithmetic(VMWriter::Command::ADD);
+	m_Writer.WritePop(ARG, 1);
+	m_Writer.WritePush(LOCAL, 1);
+	m_Writer.WritePush(LOCAL, 1);
+	m_Writer.WriteArithmetic(VMWriter::Command::ADD);
+	m_Writer.WritePop(LOCAL, 1);
+	m_Writer.WriteGoto("HALVE_LOOP");
+	m_Writer.WriteLabel("HALVE_END");
+	m_Writer.WritePush(LOCAL, 0);
+	m_Writer.WritePush(LOCAL, 2);
+	m_Writer.WriteIf("HALVE_NEGATIVE");
+	m_Writer.WriteReturn();
+	m_Writer.WriteLabel("HALVE_NEGATIVE");
+	m_Writer.WriteArithmetic(VMWriter::Command::NEG);
+	m_Writer.WriteReturn();
+}
+
+void CodeGenerator::GenerateString(std::string_view text)
+{
+	m_Writer.WritePush(VMWriter::Segment::CONST, static_cast<int>(text.size()));
+	m_Writer.WriteCall("String.new", 1);		// Pushes string base address onto stack.
+	for (char c : text)
+	{
+		m_Writer.WritePush(VMWriter::Segment::CONST, static_cast<unsigned char>(c));	// Character to append.
+		m_Writer.WriteCall("String.appendChar", 2);			// Returns string's 'this'.
+	}
+}
+
+/*
+* Statics start out as 0, which no String returned by String.new is, so
+* the static itself tells whether the string has been built:
+*
+*	push static N
+*	if-goto STRING_READYk
+*	(build the string)
+*	pop static N
+*	label STRING_READYk
+*	push static N
+*/
+void CodeGenerator::GeneratePooledString(std::string_view text)
+{
+	auto it = m_StringSlots.find(text);
+	if (it == m_StringSlots.end())
+		it = m_StringSlots.emplace(text, m_NextStringSlot++).first;
+	const int slot = it->second;
+	const std::string ready_label = std::string("STRING_READY") + std::to_string(m_LabelCount);
+	m_LabelCount++;
+	m_Writer.WritePush(VMWriter::Segment::STATIC, slot);
+	m_Writer.WriteIf(ready_label);
+	GenerateString(text);
+	m_Writer.WritePop(VMWriter::Segment::STATIC, slot);
+	m_Writer.WriteLabel(ready_label);
+	m_Writer.WritePush(VMWriter::Segment::STATIC, slot);
+}
+
+void CodeGenerator::PushInt(int value)
+{
+	if (value >= 0)
+		m_Writer.WritePush(VMWriter::Segment::CONST, value);
+	else if (value == -32768)
+	{	// -32768 is ~32767; its negation does not fit in a constant.
+		m_Writer.WritePush(VMWriter::Segment::CONST, 32767);
+		m_Writer.WriteArithmetic(VMWriter::Command::NOT);
+	}
+	else
+	{
+		m_Writer.WritePush(VMWriter::Segment::CONST, -value);
+		m_Writer.WriteArithmetic(VMWriter::Command::NEG);
+	}
+}
+} // namespace jack
@@ -0,0 +1,120 @@
+#pragma once
+#include <map>
+#include <string>
+#include <string_view>
+#include "Ast.h"
+#include "VMWriter.h"
+#include "CompilerOptions.h"
+
+namespace jack {
+/*
+* Walks the syntax tree of a class and emits its VM code through a
+* VMWriter. Labels are numbered per class, in the order their statements
+* appear.
+*
+* When optimizing, multiplications by small constants become chains of
+* additions, and divisions by powers of two calls to a helper function
+* emitted once per class, instead of calls to Math.multiply and
+* Math.divide.
+*
+* When optimizing, conditions made of comparisons, &, | and ~ are
+* compiled to jumps rather than to a value that is then tested: & and |
+* stop early when their right operand calls nothing, and loops test
+* their condition at the bottom. With the extended VM, a comparison is a
+* single if-lt, if-ge and so on.
+*
+* When optimizing, "return f(...)" in f itself reassigns the arguments
+* and jumps back to the start of f instead of calling it, so that tail
+* recursion runs as a loop in a single frame.
+*
+* With the extended VM, "let x = x + 1" and "let x = x - 1" update x in
+* place with inc and dec, "let x = y" and "let x = 5" are a single move,
+* and adding or subtracting a variable or constant uses push-add or
+* push-sub.
+*
+* THAT is live only while the value of "let a[i] = value" is computed,
+* as it already points at a[i]. When optimizing, array reads elsewhere
+* leave THAT pointing at the element they read instead of restoring it.
+*
+* When optimizing, calls to Memory.peek, Memory.poke, Math.abs, Math.max
+* and Math.min are intrinsics: their work is done in place, without a
+* call, assuming these OS functions do what the Jack OS specifies.
+*
+* Given a profile, subroutines it shows to be cold keep their calls to
+* Math.abs, Math.max and Math.min, and only multiply in place by
+* constants that take a single addition, as the calls take less ROM.
+*
+* Pooled string literals take the static variables after the class's own,
+* in the order the literals first appear.
+*/
+class CodeGenerator
+{
+public:
+	CodeGenerator(VMWriter& writer, const CompilerOptions& options);
+	void Generate(const ast::Class& cls);
+private:
+	VMWriter& m_Writer;
+	CompilerOptions m_Options;
+	// Used for label uniqueness.
+	int m_LabelCount;
+	std::string m_ClassName;
+	// Whether the class needs its halving helper.
+	bool m_UsesHalve;
+	// Static variable index of each pooled string literal.
+	std::map<std::string_view, int> m_StringSlots;
+	int m_NextStringSlot;
+	// Subroutine being generated.
+	const ast::Subroutine* m_Sub;
+	// Whether THAT holds an address that code yet to run will write through.
+	bool m_ThatLive;
+
+	// Most doublings and additions a multiplication by a constant is replaced by.
+	static const int s_MAX_MULTIPLY_STEPS;
+	// Most additions that a multiplication by a constant takes in a cold subroutine.
+	static const int s_MAX_COLD_MULTIPLY_STEPS;
+	// Name of the halving helper within its class.
+	static const char* const s_HALVE;
+	// Label at the start of a subroutine that tail calls itself.
+	static const char* const s_TAIL_CALL;
+
+	void GenerateSubroutine(const ast::Subroutine& sub);
+	void GenerateStatements(const ArenaList<ast::Stmt*>& statements);
+	// Whether expr, returned by the subroutine being generated, is a call to itself that can be a jump.
+	bool IsSelfTailCall(const ast::Expr* expr) const;
+	// Whether the profile, if any, shows the subroutine being generated to be cold.
+	bool IsCold() const;
+	bool HasSelfTailCall(const ArenaList<ast::Stmt*>& statements) const;
+	void GenerateSelfTailCall(const ast::Expr& call);
+	void GenerateLet(const ast::Stmt& stmt);
+	// Assigns value to var with a fused command of the extended VM, if there is one for it.
+	bool GenerateFusedLet(const ast::Var& var, const ast::Expr& value);
+	// Whether operand can be added or subtracted with push-add or push-sub of the extended VM.
+	bool IsFusable(const ast::Expr& operand) const;
+	// Adds operand (cmd ADD) to, or subtracts it (SUB) from, the top of the stack; operand IsFusable.
+	void GenerateFusedArithmetic(VMWriter::Command cmd, const ast::Expr& operand);
+	void GenerateIf(const ast::Stmt& stmt);
+	void GenerateWhile(const ast::Stmt& stmt);
+	// Jumps to label if cond is true (-1), when jumpIfTrue, or else if it is not.
+	void GenerateBranch(const ast::Expr& cond, const std::string& label, bool jumpIfTrue);
+	void GenerateExpression(const ast::Expr& expr);
+	void GenerateCall(const ast::Expr& call);
+	// Points THAT at var[index].
+	void GenerateArrayOffset(const ast::Var& var, const ast::Expr& index);
+	void GenerateArrayRead(const ast::Expr& expr);
+	// Pushes RAM[THAT] once THAT has been pointed by point, keeping THAT if it is live.
+	template <class Point>
+	void GenerateRead(Point point);
+	// Emits a call to an OS function without calling it, and returns whether it did.
+	bool GenerateIntrinsic(const ast::Expr& call);
+	bool GeneratePoke(const ast::Expr& call);
+	// Pushes any 16-bit value, including those no "push constant" can.
+	void PushInt(int value);
+	void GenerateString(std::string_view text);
+	// Pushes the String for text kept in a static variable, building it the first time.
+	void GeneratePooledString(std::string_view text);
+	// Emits x * c or x / c with fewer cycles than a call to Math, and returns whether it did.
+	bool GenerateMultiply(const ast::Expr& x, int c);
+	bool GenerateDivide(const ast::Expr& x, int c);
+	void GenerateHalvingHelper();
+};
+} // namespace jack
@@ -1,12 +1,35 @@
+#include <vector>
+#include <chrono>
+#include <utility>
 #include "CompilationEngine.h"
 #include "JackConstants.h"		// jack namespace string literal constants
 #include "JackTokenError.h"
 #include "JackIdentifierError.h"
+#include "Optimizer.h"
+#include "CodeGenerator.h"
 
 namespace jack {
+using Clock = std::chrono::steady_clock;
 
-CompilationEngine::CompilationEngine(std::ifstream& ifs, std::ofstream& ofs, const std::string& className)
-	:m_Tokenizer{ ifs }, m_Writer{ ofs }, m_ClassName{ className }, m_LabelCount{ 0 } 
+// Milliseconds since start.
+static double MillisecondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+CompilationEngine::CompilationEngine(std::ifstream& ifs, std::ofstream& ofs, const std::string& className,
+	const CompilerOptions& options)
+	:m_Tokenizer{ ifs }, m_Writer{ ofs }, m_ClassName{ className }, m_Options{ options }
+{}
+
+CompilationEngine::CompilationEngine(std::ifstream& ifs, const std::string& className,
+	const CompilerOptions& options)
+	:m_Tokenizer{ ifs }, m_ClassName{ className }, m_Options{ options }
+{}
+
+CompilationEngine::CompilationEngine(std::string source, const std::string& className,
+	const CompilerOptions& options)
+	:m_Tokenizer{ std::move(source) }, m_ClassName{ className }, m_Options{ options }
 {}
 
 /* Compiles a class with expected Jack syntax:
@@ -19,6 +42,7 @@ void CompilationEngine::CompileClass()
 {
 	if (m_Tokenizer.HasMoreTokens())
 	{
+		Clock::time_point start = Clock::now();
 		// Read in next token and set current.
 		m_Tokenizer.Advance();
 		if (m_Tokenizer.TokenType() != JackTokenType::KEYWORD)
@@ -27,23 +51,32 @@ void CompilationEngine::CompileClass()
 		CompileIdentifier();
 		CompileSymbol('{');
 		// All (if any) class variables must be declared at start of class.
-		std::string kw = m_Tokenizer.KeyWord();
-		JackTokenType t = m_Tokenizer.TokenType();
-		while (t == JackTokenType::KEYWORD && (kw == jack::STATIC || kw == jack::FIELD))
+		JackKeyWord kw = m_Tokenizer.KeyWordId();	// NONE unless a keyword.
+		while (kw == JackKeyWord::STATIC || kw == JackKeyWord::FIELD)
 		{
 			CompileClassVarDec();
-			t = m_Tokenizer.TokenType();
-			kw = m_Tokenizer.KeyWord();
+			kw = m_Tokenizer.KeyWordId();
 		}
 		// All (if any) subroutine declarations follow class variable declarations.
-		while (t == JackTokenType::KEYWORD &&(kw == jack::METHOD || 
-					kw == jack::CONSTRUCTOR || kw == jack::FUNCTION))
+		std::vector<ast::Subroutine*> subroutines;
+		while (kw == JackKeyWord::METHOD || kw == JackKeyWord::CONSTRUCTOR || kw == JackKeyWord::FUNCTION)
 		{
-			CompileSubroutine();
-			t = m_Tokenizer.TokenType();
-			kw = m_Tokenizer.KeyWord();
+			subroutines.push_back(CompileSubroutine());
+			kw = m_Tokenizer.KeyWordId();
 		}
 		CompileSymbol('}');
+		ast::Class* cls = m_Arena.New<ast::Class>();
+		cls->name = m_Arena.Copy(m_ClassName);
+		cls->nStatics = m_ST.VarCount(SymbolTable::Kind::STATIC);
+		cls->subroutines = m_Arena.List(subroutines);
+		m_Times.parse = MillisecondsSince(start);
+		start = Clock::now();
+		if (m_Options.optimize)
+			Optimizer{ m_Arena, m_Options.profile }.Run(*cls);
+		m_Times.optimize = MillisecondsSince(start);
+		start = Clock::now();
+		CodeGenerator{ m_Writer, m_Options }.Generate(*cls);
+		m_Times.emit = MillisecondsSince(start);
 	}
 }
 
@@ -54,9 +87,9 @@ void CompilationEngine::CompileClass()
 */
 void CompilationEngine::CompileClassVarDec()
 {
-	const std::string scope_kw = m_Tokenizer.KeyWord();
-	CompileKeyWord(scope_kw);
-	SymbolTable::Kind kind = (scope_kw == jack::FIELD) ? 
+	const JackKeyWord scope_kw = m_Tokenizer.KeyWordId();
+	CompileKeyWord(m_Tokenizer.KeyWord());
+	SymbolTable::Kind kind = (scope_kw == JackKeyWord::FIELD) ? 
 			SymbolTable::Kind::FIELD : SymbolTable::Kind::STATIC;
 	const std::string type = CompileType();
 	m_ST.Define(m_Tokenizer.Identifier(), type, kind);	// Add variable to Symbol Table.
@@ -78,47 +111,37 @@ void CompilationEngine::CompileClassVarDec()
 *	// *(statements)*
 * }
 */
-void CompilationEngine::CompileSubroutine()
+ast::Subroutine* CompilationEngine::CompileSubroutine()
 {
 	// Start subroutine header.
 	m_ST.StartSubroutine();
-	const std::string& kw = m_Tokenizer.KeyWord();	// "function", "method", "constructor".
-	CompileKeyWord(kw);
+	ast::Subroutine* sub = m_Arena.New<ast::Subroutine>();
+	sub->kind = m_Tokenizer.KeyWordId();	// "function", "method", "constructor".
+	CompileKeyWord(m_Tokenizer.KeyWord());
 	// Return type may be void, primitive-type, or user-defined type.
-	if (m_Tokenizer.TokenType() == JackTokenType::KEYWORD && 
-			m_Tokenizer.KeyWord() == jack::VOID)
+	if (m_Tokenizer.KeyWordId() == JackKeyWord::VOID)
 		CompileKeyWord(jack::VOID);
 	else
 		CompileType();
-	// Used below in writing a VM 'function' command.
-	const std::string& funcName = m_ClassName + "." + m_Tokenizer.Identifier();
+	// Used in writing a VM 'function' command.
+	sub->name = m_Arena.Copy(m_ClassName + "." + std::string(m_Tokenizer.Identifier()));
 	CompileIdentifier();
-	if (kw == jack::METHOD)			// First argument to instance method is 'this'.
+	if (sub->kind == JackKeyWord::METHOD)	// First argument to instance method is 'this'.
 		m_ST.Define(jack::THIS, m_ClassName, SymbolTable::Kind::ARG);
 	CompileSymbol('(');
 	CompileParameterList();
+	sub->nArgs = m_ST.VarCount(SymbolTable::Kind::ARG);
 	CompileSymbol(')');
 	// End header and begin Subroutine body.
 	CompileSymbol('{');
 	// All variable declarations must appear at start of subroutine body.
-	while (m_Tokenizer.TokenType() == JackTokenType::KEYWORD &&
-			m_Tokenizer.KeyWord() == jack::VAR)
+	while (m_Tokenizer.KeyWordId() == JackKeyWord::VAR)
 		CompileVarDec();
-	int nLocals = m_ST.VarCount(SymbolTable::Kind::VAR);
-	m_Writer.WriteFunction(funcName, nLocals);
-	if (kw == jack::METHOD)
-	{	// First argument is "this"; set its base address in current scope.		
-		m_Writer.WritePush(VMWriter::Segment::ARG, 0);
-		m_Writer.WritePop(VMWriter::Segment::POINTER, 0);
-	} 
-	else if (kw == jack::CONSTRUCTOR)
-	{	// Allocate memory for object.
-		m_Writer.WritePush(VMWriter::Segment::CONST, m_ST.VarCount(SymbolTable::Kind::FIELD));
-		m_Writer.WriteCall("Memory.alloc", 1);	// Returns base address of object created.
-		m_Writer.WritePop(VMWriter::Segment::POINTER, 0);	// Set "this" to that base address.
-	}
-	CompileStatements();
+	sub->nLocals = m_ST.VarCount(SymbolTable::Kind::VAR);
+	sub->nFields = m_ST.VarCount(SymbolTable::Kind::FIELD);
+	sub->body = CompileStatements();
 	CompileSymbol('}');
+	return sub;
 }
 
 void CompilationEngine::CompileParameterList()
@@ -133,7 +156,7 @@ void CompilationEngine::CompileParameterList()
 		while (m_Tokenizer.TokenType() == JackTokenType::SYMBOL && m_Tokenizer.Symbol() == ',')
 		{
 			CompileSymbol(',');
-			CompileType();
+			type = CompileType();
 			m_ST.Define(m_Tokenizer.Identifier(), type, SymbolTable::Kind::ARG);
 			CompileIdentifier();
 		}
@@ -156,196 +179,173 @@ void CompilationEngine::CompileVarDec()
 	CompileSymbol(';');
 }
 
-void CompilationEngine::CompileStatements()
+ArenaList<ast::Stmt*> CompilationEngine::CompileStatements()
 {
+	std::vector<ast::Stmt*> statements;
 	while (m_Tokenizer.TokenType() == JackTokenType::KEYWORD)
 	{
-		const std::string& kw = m_Tokenizer.KeyWord();
-		if (kw == jack::DO)
-			CompileDo();
-		else if (kw == jack::LET)
-			CompileLet();
-		else if (kw == jack::WHILE)
-			CompileWhile();
-		else if (kw == jack::RETURN)
-			CompileReturn();
-		else if (kw == jack::IF)
-			CompileIf();
-		else
-			throw JackTokenError(std::string("Unexpected keyword ") + kw);
+		switch (m_Tokenizer.KeyWordId())
+		{
+		case JackKeyWord::DO:
+			statements.push_back(CompileDo());
+			break;
+		case JackKeyWord::LET:
+			statements.push_back(CompileLet());
+			break;
+		case JackKeyWord::WHILE:
+			statements.push_back(CompileWhile());
+			break;
+		case JackKeyWord::RETURN:
+			statements.push_back(CompileReturn());
+			break;
+		case JackKeyWord::IF:
+			statements.push_back(CompileIf());
+			break;
+		default:
+			throw JackTokenError("Unexpected keyword " + std::string(m_Tokenizer.KeyWord()));
+		}
 	}
+	return m_Arena.List(statements);
 }
 
 
 // do subroutineName();
-void CompilationEngine::CompileDo()
+ast::Stmt* CompilationEngine::CompileDo()
 {
 	CompileKeyWord(jack::DO);
+	ast::Stmt* stmt = NewStmt(ast::StmtKind::DO);
 	// Ambiguous: class name, subroutine name, or variable name.
-	std::string name = m_Tokenizer.Identifier();
+	std::string name{ m_Tokenizer.Identifier() };
 	CompileIdentifier();
-	CompileSubroutineCall(name);
+	stmt->expr = CompileSubroutineCall(name);
 	CompileSymbol(';');
-	m_Writer.WritePop(VMWriter::Segment::TEMP, 0);	// Ignore return value.
+	return stmt;
 }
 
 /* Jack assignment statement:
 * Example 1: let x = 5 * 8;
 * Example 2: let a[i] = 2 * a[i-1];
 */
-void CompilationEngine::CompileLet()
+ast::Stmt* CompilationEngine::CompileLet()
 {
 	CompileKeyWord(jack::LET);
-	const std::string name = m_Tokenizer.Identifier();
+	ast::Stmt* stmt = NewStmt(ast::StmtKind::LET);
+	const std::string_view name = m_Tokenizer.Identifier();
 	CompileIdentifier();
-	// Name and segment may change in array entry.
-	VMWriter::Segment sgmt = NameToSgmt(name);
-	int index = m_ST.IndexOf(name);
+	stmt->var = NameToVar(name);
 	if (m_Tokenizer.TokenType() == JackTokenType::SYMBOL && m_Tokenizer.Symbol() == '[')
 	{	// Assigning to array entry.
-		ComputeArrayOffset(sgmt, index);
-		sgmt = VMWriter::Segment::THAT;
-		index = 0;
+		CompileSymbol('[');
+		stmt->index = CompileExpression();
+		CompileSymbol(']');
 	}
 	CompileSymbol('=');
-	// Expression may be an array entry, like a[i-1]; may affect 'that' base above.
-	CompileExpression();
+	stmt->expr = CompileExpression();
 	CompileSymbol(';');
-	// Complete assignment, e.g., a[5] = 10; or a[i] = 2 * a[i-1]);
-	m_Writer.WritePop(sgmt, index);
+	return stmt;
 }
 
-void CompilationEngine::CompileWhile()
+ast::Stmt* CompilationEngine::CompileWhile()
 {
-	const std::string end_while_label = std::string("END_WHILE") + std::to_string(m_LabelCount);
-	const std::string while_test_label = std::string("WHILE_RETRY") + std::to_string(m_LabelCount);
-	m_LabelCount++;
 	CompileKeyWord(jack::WHILE);
-	m_Writer.WriteLabel(while_test_label);
+	ast::Stmt* stmt = NewStmt(ast::StmtKind::WHILE);
 	CompileSymbol('(');
-	CompileExpression();
+	stmt->expr = CompileExpression();
 	CompileSymbol(')');
-	m_Writer.WriteArithmetic(VMWriter::Command::NOT);
-	m_Writer.WriteIf(end_while_label);
 	CompileSymbol('{');
-	CompileStatements();
-	m_Writer.WriteGoto(while_test_label);
+	stmt->body = CompileStatements();
 	CompileSymbol('}');
-	m_Writer.WriteLabel(end_while_label);
+	return stmt;
 }
 
-void CompilationEngine::CompileReturn()
+ast::Stmt* CompilationEngine::CompileReturn()
 {
 	CompileKeyWord(jack::RETURN);
-	
-	// Compute return value.
+	ast::Stmt* stmt = NewStmt(ast::StmtKind::RETURN);
+	// Return value, if any.
 	if (m_Tokenizer.TokenType() != JackTokenType::SYMBOL || m_Tokenizer.Symbol() != ';')
-		CompileExpression();
-	else // Empty return statement; push 0.
-		m_Writer.WritePush(VMWriter::Segment::CONST, 0);
+		stmt->expr = CompileExpression();
 	CompileSymbol(';');
-	m_Writer.WriteReturn();
+	return stmt;
 }
 
-void CompilationEngine::CompileIf()
+ast::Stmt* CompilationEngine::CompileIf()
 {
-	const std::string else_label = std::string("ELSE") + std::to_string(m_LabelCount);
-	const std::string end_if_label = std::string("END_IF") + std::to_string(m_LabelCount);
-	m_LabelCount++;
 	CompileKeyWord(jack::IF);
+	ast::Stmt* stmt = NewStmt(ast::StmtKind::IF);
 	CompileSymbol('(');
-	CompileExpression();
+	stmt->expr = CompileExpression();
 	CompileSymbol(')');
-	m_Writer.WriteArithmetic(VMWriter::Command::NOT);
-	m_Writer.WriteIf(else_label);
 	CompileSymbol('{');
-	CompileStatements();
+	stmt->body = CompileStatements();
 	CompileSymbol('}');
-	m_Writer.WriteGoto(end_if_label);
-	m_Writer.WriteLabel(else_label);
 	// Optional else statement following if.
-	if (m_Tokenizer.TokenType() == JackTokenType::KEYWORD && 
-			m_Tokenizer.KeyWord() == jack::ELSE)
+	if (m_Tokenizer.KeyWordId() == JackKeyWord::ELSE)
 	{
 		CompileKeyWord(jack::ELSE);
 		CompileSymbol('{');
-		CompileStatements();
+		stmt->elseBody = CompileStatements();
 		CompileSymbol('}');
 	}
-	m_Writer.WriteLabel(end_if_label);
+	return stmt;
 }
 
-void CompilationEngine::CompileExpression()
+/*
+* Jack has no operator precedence: term (op term)* is evaluated from left
+* to right, so a - b + c is (a - b) + c.
+*/
+ast::Expr* CompilationEngine::CompileExpression()
 {
-	CompileTerm();
-	if (m_Tokenizer.TokenType() == JackTokenType::SYMBOL)
+	ast::Expr* expr = CompileTerm();
+	while (m_Tokenizer.TokenType() == JackTokenType::SYMBOL)
 	{
 		char op = m_Tokenizer.Symbol();
-		if (op == '+' || op == '-' || op == '*' || op == '/' ||
-			op == '&' || op == '|' || op == '<' || op == '>' ||
-			op == '=')
-		{
-			CompileSymbol(op);
-			CompileTerm();
-			if (op == '+')
-				m_Writer.WriteArithmetic(VMWriter::Command::ADD);
-			else if (op == '-')
-				m_Writer.WriteArithmetic(VMWriter::Command::SUB);
-			else if (op == '*')
-				m_Writer.WriteCall("Math.multiply", 2);
-			else if (op == '/')
-				m_Writer.WriteCall("Math.divide", 2);
-			else if (op == '&')
-				m_Writer.WriteArithmetic(VMWriter::Command::AND);
-			else if (op == '|')
-				m_Writer.WriteArithmetic(VMWriter::Command::OR);
-			else if (op == '>')
-				m_Writer.WriteArithmetic(VMWriter::Command::GT);
-			else if (op == '<')
-				m_Writer.WriteArithmetic(VMWriter::Command::LT);
-			else if (op == '=')
-				m_Writer.WriteArithmetic(VMWriter::Command::EQ);
-		}
+		if (op != '+' && op != '-' && op != '*' && op != '/' &&
+			op != '&' && op != '|' && op != '<' && op != '>' &&
+			op != '=')
+			break;
+		CompileSymbol(op);
+		ast::Expr* binary = NewExpr(ast::ExprKind::BINARY);
+		binary->op = op;
+		binary->left = expr;
+		binary->right = CompileTerm();
+		expr = binary;
 	}
+	return expr;
 }
 
-void CompilationEngine::CompileTerm()
+ast::Expr* CompilationEngine::CompileTerm()
 {
 	JackTokenType t = m_Tokenizer.TokenType();
+	ast::Expr* expr = nullptr;
 	if (t == JackTokenType::INT_CONST)
 	{
-		m_Writer.WritePush(VMWriter::Segment::CONST, m_Tokenizer.IntVal());
+		expr = NewExpr(ast::ExprKind::INT);
+		expr->value = m_Tokenizer.IntVal();
 		if (m_Tokenizer.HasMoreTokens())
 			m_Tokenizer.Advance();
 	}
 	else if (t == JackTokenType::STRING_CONST)
 	{
-		const std::string& s = m_Tokenizer.StringVal();
-		m_Writer.WritePush(VMWriter::Segment::CONST, s.size());
-		m_Writer.WriteCall("String.new", 1);		// Pushes string base address onto stack.
-		for (char c : s)
-		{
-			m_Writer.WritePush(VMWriter::Segment::CONST, c);	// Character to append.
-			m_Writer.WriteCall("String.appendChar", 2);			// Returns string's 'this'.
-		}
+		expr = NewExpr(ast::ExprKind::STRING);
+		expr->text = m_Tokenizer.StringVal();	// Views the tokenizer's source.
 		if (m_Tokenizer.HasMoreTokens())
 			m_Tokenizer.Advance();
 	}
 	else if (t == JackTokenType::KEYWORD)	// Jack constant (null, true, false, this).
 	{
-		const std::string kw = m_Tokenizer.KeyWord();
-		if (kw == jack::J_NULL || kw == jack::FALSE)
-			m_Writer.WritePush(VMWriter::Segment::CONST, 0);
-		else if (kw == jack::TRUE)
-		{
-			m_Writer.WritePush(VMWriter::Segment::CONST, 1);
-			m_Writer.WriteArithmetic(VMWriter::Command::NEG);
-		}
-		else if (kw == jack::THIS)
-			m_Writer.WritePush(VMWriter::Segment::POINTER, 0);
+		const JackKeyWord kw = m_Tokenizer.KeyWordId();
+		if (kw == JackKeyWord::J_NULL)
+			expr = NewExpr(ast::ExprKind::J_NULL);
+		else if (kw == JackKeyWord::FALSE)
+			expr = NewExpr(ast::ExprKind::FALSE);
+		else if (kw == JackKeyWord::TRUE)
+			expr = NewExpr(ast::ExprKind::TRUE);
+		else if (kw == JackKeyWord::THIS)
+			expr = NewExpr(ast::ExprKind::THIS);
 		else
-			throw JackTokenError(std::string("Unexpected keyword ") + kw);;
-		CompileKeyWord(kw);
+			throw JackTokenError("Unexpected keyword " + std::string(m_Tokenizer.KeyWord()));
+		CompileKeyWord(m_Tokenizer.KeyWord());
 	}
 	else if (t == JackTokenType::SYMBOL)
 	{
@@ -353,70 +353,61 @@ void CompilationEngine::CompileTerm()
 		if (c == '(')
 		{ // Parenthesized expression.
 			CompileSymbol('(');
-			CompileExpression();
+			expr = CompileExpression();
 			CompileSymbol(')');
 		}
 		else if (c == '-' || c == '~')
 		{ // Expression with unary operation.
 			CompileSymbol(c);
-			CompileTerm();
-			VMWriter::Command cmd = VMWriter::Command::NEG;
-			if (c == '~')
-				 cmd = VMWriter::Command::NOT;
-			m_Writer.WriteArithmetic(cmd);
+			expr = NewExpr(ast::ExprKind::UNARY);
+			expr->op = c;
+			expr->left = CompileTerm();
 		}
 		else
 			throw JackTokenError(std::string("Unexpected symbol ") + c);
 	}
 	else if (t == JackTokenType::IDENTIFIER)
 	{
-		std::string name = m_Tokenizer.Identifier();
+		const std::string_view name = m_Tokenizer.Identifier();
 		CompileIdentifier();
 		t = m_Tokenizer.TokenType();
 		char c = m_Tokenizer.Symbol();
 		// Case 1: Accessing variable value.
 		if (t != JackTokenType::SYMBOL || (c != '[' && c != '.' && c != '('))
-			m_Writer.WritePush(NameToSgmt(name), m_ST.IndexOf(name));
-		else                                      
-		{// Case 2: Array entry, or subroutine call.
-			if (c == '[')
-			{	// Subcase 1: Array entry value.
-
-				/* 
-				* Array value computed below may be assigned to another
-				* array entry, as in a[i] = a[i-1]. To be safe, preserve 'THAT'.
-				*/
-				m_Writer.WritePush(VMWriter::Segment::POINTER, 1);
-				m_Writer.WritePop(VMWriter::Segment::TEMP, 0);
-				ComputeArrayOffset(NameToSgmt(name), m_ST.IndexOf(name));
-				m_Writer.WritePush(VMWriter::Segment::THAT, 0);	// Push entry value.
-				m_Writer.WritePush(VMWriter::Segment::TEMP, 0);	// Restore old "that".
-				m_Writer.WritePop(VMWriter::Segment::POINTER, 1);
-			}
-			else if (c == '.' || c == '(')	// Subcase 2: Subroutine call.
-				CompileSubroutineCall(name);
+		{
+			expr = NewExpr(ast::ExprKind::VAR);
+			expr->var = NameToVar(name);
 		}
+		else if (c == '[')
+		{	// Case 2: Array entry value.
+			expr = NewExpr(ast::ExprKind::INDEX);
+			expr->var = NameToVar(name);
+			CompileSymbol('[');
+			expr->left = CompileExpression();
+			CompileSymbol(']');
+		}
+		else	// Case 3: Subroutine call.
+			expr = CompileSubroutineCall(name);
 	}
 	else
-		throw JackTokenError(m_Tokenizer.Identifier());
+		throw JackTokenError(std::string(m_Tokenizer.Identifier()));
+	return expr;
 }
 
-int CompilationEngine::CompileExpressionList()
+ArenaList<ast::Expr*> CompilationEngine::CompileExpressionList()
 {
 	JackTokenType t = m_Tokenizer.TokenType();
-	int n_args = 0;
+	std::vector<ast::Expr*> args;
 	if (t != JackTokenType::SYMBOL || m_Tokenizer.Symbol() != ')')
 	{
-		CompileExpression();
-		n_args++;
+		args.push_back(CompileExpression());
 		while (m_Tokenizer.TokenType() == JackTokenType::SYMBOL && m_Tokenizer.Symbol() == ',')
 		{
 			CompileSymbol(',');
-			CompileExpression();
-			n_args++;
+			args.push_back(CompileExpression());
 		}
 	}
-	return n_args;
+	return m_Arena.List(args);
 }
 
 void CompilationEngine::CompileSymbol(char c)
@@ -431,15 +422,14 @@ void CompilationEngine::CompileIdentifier()
 {
 	if (m_Tokenizer.TokenType() != JackTokenType::IDENTIFIER)
 		throw JackTokenError("Expected identifier");
-	const std::string& name = m_Tokenizer.Identifier();
 	if (m_Tokenizer.HasMoreTokens())
 		m_Tokenizer.Advance();
 }
 
-void CompilationEngine::CompileKeyWord(const std::string& kw)
+void CompilationEngine::CompileKeyWord(std::string_view kw)
 {
-	if (m_Tokenizer.KeyWord() != kw)
-		throw JackTokenError(std::string("Expected ") + kw);
+	if (m_Tokenizer.TokenType() != JackTokenType::KEYWORD || m_Tokenizer.KeyWord() != kw)
+		throw JackTokenError("Expected " + std::string(kw));
 	if (m_Tokenizer.HasMoreTokens())
 		m_Tokenizer.Advance();
 }
@@ -464,54 +454,43 @@ const std::string CompilationEngine::CompileType()
 	}
 }
 
-void CompilationEngine::ComputeArrayOffset(VMWriter::Segment sgmt, int index)
-{
-	m_Writer.WritePush(sgmt, index);		// Base address of array.
-	CompileSymbol('[');						// Compute array index, e.g. value 5.
-	CompileExpression();
-	CompileSymbol(']');						// End array index comp (on stack).
-	m_Writer.WriteArithmetic(VMWriter::Command::ADD);	// E.g. a[5] or *(a+5).
-	m_Writer.WritePop(VMWriter::Segment::POINTER, 1);
-}
-
 /* Subroutine call occurs in expression OR in do statement.
 * Example 1: do Output.println("Hello");	static method.
 * Example 2: do player.jump();				instance method on variable in scope.
 * Example 3: do draw();						instance method on current class object.
 * Example 4: let h = h + player.height();
 */
-void CompilationEngine::CompileSubroutineCall(std::string& name)
+ast::Expr* CompilationEngine::CompileSubroutineCall(std::string_view name)
 {
-	int n_args = 0;
+	ast::Expr* call = NewExpr(ast::ExprKind::CALL);
 	if (m_Tokenizer.TokenType() == JackTokenType::SYMBOL && m_Tokenizer.Symbol() == '.')
 	{ // Case 1: name is a class name or variable name.
 		CompileSymbol('.');
-		const std::string& method_name = m_Tokenizer.Identifier();
+		const std::string method_name{ m_Tokenizer.Identifier() };
 		CompileIdentifier();
-		if (m_ST.KindOf(name) != SymbolTable::Kind::NONE)
-		{ // Subcase 1: name is a class name
-			m_Writer.WritePush(NameToSgmt(name), m_ST.IndexOf(name));
-			n_args++;	// Variable that method is called on is first argument.
-			name = m_ST.TypeOf(name) + "." + method_name;
+		if (const SymbolTable::Entry* var = m_ST.Lookup(name))
+		{ // Subcase 1: name is a variable; its object is the first argument.
+			call->left = NewExpr(ast::ExprKind::VAR);
+			call->left->var = { KindToSgmt(var->kind), var->index };
+			call->text = m_Arena.Copy(m_ST.TypeOf(*var) + "." + method_name);
 		}
 		else // Subcase 2: name is a class name.
-			name = name + "." + method_name;
+			call->text = m_Arena.Copy(std::string(name) + "." + method_name);
 	}
 	else
 	{	// Case 2: name is an instance method.
-		m_Writer.WritePush(VMWriter::Segment::POINTER, 0);
-		n_args++;
-		name = m_ClassName + "." + name;
+		call->left = NewExpr(ast::ExprKind::THIS);
+		call->text = m_Arena.Copy(m_ClassName + "." + std::string(name));
 	}
 	CompileSymbol('(');
-	n_args += CompileExpressionList();
+	call->args = CompileExpressionList();
 	CompileSymbol(')');
-	m_Writer.WriteCall(name, n_args);
+	return call;
 }
 
-VMWriter::Segment CompilationEngine::NameToSgmt(const std::string& name)
+VMWriter::Segment CompilationEngine::KindToSgmt(SymbolTable::Kind kind)
 {
-	switch (m_ST.KindOf(name))
+	switch (kind)
 	{
 	case SymbolTable::Kind::VAR:
 		return VMWriter::Segment::LOCAL;
@@ -519,11 +498,27 @@ VMWriter::Segment CompilationEngine::NameToSgmt(const std::string& name)
 		return VMWriter::Segment::ARG;
 	case SymbolTable::Kind::STATIC:
 		return VMWriter::Segment::STATIC;
-	case SymbolTable::Kind::FIELD:
+	default:	// FIELD
 		return VMWriter::Segment::THIS;
-	default:
-		throw JackIdentifierError(name);
 	}
 }
 
-} // namespace jack
\ No newline at end of file
+ast::Var CompilationEngine::NameToVar(std::string_view name)
+{
+	const SymbolTable::Entry* var = m_ST.Lookup(name);
+	if (!var)
+		throw JackIdentifierError(std::string(name));
+	return { KindToSgmt(var->kind), var->index };
+}
+
+ast::Expr* CompilationEngine::NewExpr(ast::ExprKind kind)
+{
+	return m_Arena.New<ast::Expr>(ast::Expr{ kind, 0, '\0', {}, {}, nullptr, nullptr, {}, false });
+}
+
+ast::Stmt* CompilationEngine::NewStmt(ast::StmtKind kind)
+{
+	return m_Arena.New<ast::Stmt>(ast::Stmt{ kind, {}, nullptr, nullptr, {}, {} });
+}
+
+} // namespace jack
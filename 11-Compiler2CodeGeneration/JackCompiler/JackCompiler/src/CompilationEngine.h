@@ -1,24 +1,44 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <fstream>
 #include "JackTokenizer.h"
 #include "SymbolTable.h"
 #include "VMWriter.h"
+#include "Arena.h"
+#include "Ast.h"
+#include "CompilerOptions.h"
+#include "CompileStats.h"
 
 namespace jack {
 /*
-* Uses the parsed Tokens from the JackTokenizer as its input
-* and uses recursive descent parsing to emit an XML file in a way
-* that adheres to Jack's grammar.
+* Uses the parsed Tokens from the JackTokenizer as its input and uses
+* recursive descent parsing to build the syntax tree of a class in a way
+* that adheres to Jack's grammar. The tree is then optimized and handed to
+* the CodeGenerator, which emits its VM code.
 */
 class CompilationEngine
 {
 public:
-	// Creates a Tokenizer and output XML file to write to.
-	CompilationEngine(std::ifstream& ifs, std::ofstream& ofs, const std::string& className);
+	// Creates a Tokenizer and output VM file to write to.
+	CompilationEngine(std::ifstream& ifs, std::ofstream& ofs, const std::string& className,
+		const CompilerOptions& options = {});
+	// Keeps the VM code in memory instead; see Output().
+	CompilationEngine(std::ifstream& ifs, const std::string& className,
+		const CompilerOptions& options = {});
+	// Compiles source text already read, into memory.
+	CompilationEngine(std::string source, const std::string& className,
+		const CompilerOptions& options = {});
 
-	// Creates the XML for the class provided upon construction.
+	// Compiles the class provided upon construction.
 	void CompileClass();
+	// VM code compiled so far, when not written to a file.
+	const std::string& Output() const { return m_Writer.Output(); }
+	/*
+	* Time spent parsing, optimizing and emitting the class. Tokenizing is
+	* left at 0: it all happens in the constructor, so callers time it.
+	*/
+	const PhaseTimes& Times() const { return m_Times; }
 private:
 	JackTokenizer m_Tokenizer;
 	// Contains information about each variable in the current scope.
@@ -27,26 +47,27 @@ private:
 	VMWriter m_Writer;
 	// Name of class being written.
 	std::string m_ClassName;
-	// Used for label uniqueness.
-	int m_LabelCount;
+	CompilerOptions m_Options;
+	// Holds the syntax tree of the class.
+	Arena m_Arena;
+	PhaseTimes m_Times;
 
 	// Static variables or fields.
 	void CompileClassVarDec();
 	// Function, method, or constructor declaration (definition), not call.
-	void CompileSubroutine();
+	ast::Subroutine* CompileSubroutine();
 	void CompileParameterList();
 	// Local variables, non-arguments/parameters.
 	void CompileVarDec();
-	void CompileStatements();
-	void CompileDo();
-	void CompileLet();
-	void CompileWhile();
-	void CompileReturn();
-	void CompileIf();
-	void CompileExpression();
-	void CompileTerm();
-	// Returns number of arguments in list for use in subroutine call.
-	int CompileExpressionList();
+	ArenaList<ast::Stmt*> CompileStatements();
+	ast::Stmt* CompileDo();
+	ast::Stmt* CompileLet();
+	ast::Stmt* CompileWhile();
+	ast::Stmt* CompileReturn();
+	ast::Stmt* CompileIf();
+	ast::Expr* CompileExpression();
+	ast::Expr* CompileTerm();
+	ArenaList<ast::Expr*> CompileExpressionList();
 
 	/*
 	* The following are helper methods. Each of them check for
@@ -54,15 +75,16 @@ private:
 	*/
 	void CompileSymbol(char c);
 	void CompileIdentifier();
-	void CompileKeyWord(const std::string& kw);
+	void CompileKeyWord(std::string_view kw);
 	// Outputs user-defined type or non-void primitive type; returns type.
 	const std::string CompileType();
 
-	// Compiles and computes array entry.
-	void ComputeArrayOffset(VMWriter::Segment sgmt, int index);
-	// Compiles a subroutine call with where return value (if any) is ignored.
-	void CompileSubroutineCall(std::string& name);
-	// Maps a variable name to its corresponding segment.
-	VMWriter::Segment NameToSgmt(const std::string& name);
+	// Compiles a subroutine call whose name (or object/class) has been read.
+	ast::Expr* CompileSubroutineCall(std::string_view name);
+	// Maps a variable to its corresponding segment.
+	static VMWriter::Segment KindToSgmt(SymbolTable::Kind kind);
+	ast::Var NameToVar(std::string_view name);
+	ast::Expr* NewExpr(ast::ExprKind kind);
+	ast::Stmt* NewStmt(ast::StmtKind kind);
 };
 } // namespace jack
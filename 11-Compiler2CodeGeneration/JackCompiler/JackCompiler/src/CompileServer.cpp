@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include "BuildCache.h"
+#include "CompilationEngine.h"
+#include "CompileServer.h"
+
+namespace fs = std::filesystem;
+
+namespace jack {
+// JSON-RPC 2.0 error codes.
+static const int PARSE_ERROR = -32700;
+static const int INVALID_REQUEST = -32600;
+static const int METHOD_NOT_FOUND = -32601;
+static const int INVALID_PARAMS = -32602;
+static const int INTERNAL_ERROR = -32603;
+
+static JsonValue MakeString(const std::string& text)
+{
+	JsonValue value;
+	value.type = JsonValue::Type::STRING;
+	value.string = text;
+	return value;
+}
+
+static JsonValue MakeBool(bool b)
+{
+	JsonValue value;
+	value.type = JsonValue::Type::BOOL;
+	value.boolean = b;
+	return value;
+}
+
+static JsonValue MakeObject()
+{
+	JsonValue value;
+	value.type = JsonValue::Type::OBJECT;
+	return value;
+}
+
+// Writes one line answering request id with result, or with error if it has a message.
+static void Respond(std::ostream& os, const JsonValue& id, const JsonValue& result,
+	int code = 0, const std::string& message = "")
+{
+	os << "{\"jsonrpc\": \"2.0\", \"id\": ";
+	WriteJson(os, id);
+	if (message.empty())
+	{
+		os << ", \"result\": ";
+		WriteJson(os, result);
+	}
+	else
+	{
+		os << ", \"error\": {\"code\": " << code << ", \"message\": ";
+		WriteJsonString(os, message);
+		os << "}";
+	}
+	os << "}" << std::endl;
+}
+
+void CompileServer::Run(std::istream& is, std::ostream& os)
+{
+	std::string line;
+	while (std::getline(is, line))
+	{
+		if (line.find_first_not_of(" \t\r") == std::string::npos)
+			continue;
+		JsonValue request;
+		try
+		{
+			request = ParseJson(line);
+		}
+		catch (const std::invalid_argument& e)
+		{
+			Respond(os, {}, {}, PARSE_ERROR, e.what());
+			continue;
+		}
+		const JsonValue* id = request.Find("id");
+		const JsonValue no_id;
+		if (!id)
+			id = &no_id;
+		const JsonValue* method = request.Find("method");
+		if (!method || method->type != JsonValue::Type::STRING)
+		{
+			Respond(os, *id, {}, INVALID_REQUEST, "Expected a method");
+			continue;
+		}
+		if (method->string == "shutdown")
+		{
+			Respond(os, *id, {});
+			return;
+		}
+		if (method->string != "compile")
+		{
+			Respond(os, *id, {}, METHOD_NOT_FOUND, "Unknown method " + method->string);
+			continue;
+		}
+		try
+		{
+			Respond(os, *id, Compile(request.Find("params")));
+		}
+		catch (const std::invalid_argument& e)
+		{
+			Respond(os, *id, {}, INVALID_PARAMS, e.what());
+		}
+		catch (const std::exception& e)
+		{	// Such as a filesystem error on the paths; the server keeps going.
+			Respond(os, *id, {}, INTERNAL_ERROR, e.what());
+		}
+	}
+}
+
+/*
+* Unlike a compile from the command line, every class is compiled even if
+* an earlier one fails, so that all their errors are reported.
+*/
+JsonValue CompileServer::Compile(const JsonValue* params)
+{
+	const JsonValue* path = params ? params->Find("path") : nullptr;
+	if (!path || path->type != JsonValue::Type::STRING)
+		throw std::invalid_argument("Expected a path");
+	const JsonValue* out_dir = params->Find("outDir");
+	if (out_dir && out_dir->type != JsonValue::Type::STRING)
+		throw std::invalid_argument("Expected outDir to be a string");
+	const fs::path out_path = fs::absolute(out_dir ? out_dir->string : ".");
+	std::vector<fs::path> abs_file_paths;
+	const fs::path prgm_path = fs::absolute(path->string);
+	if (fs::is_directory(prgm_path))
+	{
+		for (auto& f : fs::directory_iterator{ prgm_path })
+			if (f.is_regular_file() && f.path().extension() == ".jack")
+				abs_file_paths.emplace_back(f);
+	}
+	else if (fs::is_regular_file(prgm_path) && prgm_path.extension() == ".jack")
+		abs_file_paths.push_back(prgm_path);
+	else
+		throw std::invalid_argument("Not a Jack file or directory: " + path->string);
+	std::sort(abs_file_paths.begin(), abs_file_paths.end());
+	fs::create_directories(out_path);
+
+	JsonValue result = MakeObject();
+	JsonValue& classes = result.object["classes"];
+	classes.type = JsonValue::Type::ARRAY;
+	bool ok = true;
+	for (const fs::path& p : abs_file_paths)
+	{
+		bool compiled;
+		const Entry& entry = CompileClass(p, out_path, compiled);
+		JsonValue cls = MakeObject();
+		cls.object["file"] = MakeString(p.string());
+		cls.object["compiled"] = MakeBool(compiled);
+		if (!entry.error.empty())
+		{
+			cls.object["error"] = MakeString(entry.error);
+			ok = false;
+		}
+		classes.array.push_back(std::move(cls));
+	}
+	result.object["ok"] = MakeBool(ok);
+	return result;
+}
+
+const CompileServer::Entry& CompileServer::CompileClass(const fs::path& path, const fs::path& outDir, bool& compiled)
+{
+	std::ifstream ifs{ path, std::ios::binary };
+	std::ostringstream source;
+	source << ifs.rdbuf();
+	ifs.close();
+	const uint64_t hash = BuildCache::Hash(source.str());
+	auto it = m_Classes.find(path);
+	compiled = (it == m_Classes.end() || it->second.sourceHash != hash);
+	if (compiled)
+	{
+		Entry entry;
+		entry.sourceHash = hash;
+		try
+		{
+			// Compiles the very text that was hashed, so the entry matches its hash.
+			CompilationEngine engine{ source.str(), path.stem().string(), m_Options };
+			try
+			{
+				engine.CompileClass();
+			}
+			catch (const std::exception& e)
+			{
+				entry.error = e.what();
+			}
+			entry.vm = engine.Output();
+		}
+		catch (const std::exception& e)
+		{
+			entry.error = e.what();
+		}
+		it = m_Classes.insert_or_assign(path, std::move(entry)).first;
+	}
+	Entry& entry = it->second;
+	const fs::path vm_path = outDir / (path.stem().string() + ".vm");
+	std::error_code ec;
+	if (compiled || entry.vmPath != vm_path || fs::last_write_time(vm_path, ec) != entry.vmTime || ec)
+	{
+		{
+			std::ofstream ofs{ vm_path, std::ios::binary };
+			ofs.write(entry.vm.data(), entry.vm.size());
+		}
+		entry.vmPath = vm_path;
+		entry.vmTime = fs::last_write_time(vm_path, ec);
+	}
+	return entry;
+}
+} // namespace jack
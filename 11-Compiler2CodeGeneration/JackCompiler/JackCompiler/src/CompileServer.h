@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <string>
+#include "CompilerOptions.h"
+#include "Json.h"
+
+namespace jack {
+/*
+* Compiles Jack classes on request for as long as it runs, for editors and
+* build scripts that compile often. Requests are JSON-RPC 2.0 calls, one
+* per line of input, and each response is one line of output:
+*
+*	{"jsonrpc": "2.0", "id": 1, "method": "compile",
+*	 "params": {"path": "Pong", "outDir": "build"}}
+*	{"jsonrpc": "2.0", "id": 1, "result": {"ok": true, "classes": [
+*	 {"file": ".../Pong/Ball.jack", "compiled": false}, ...]}}
+*
+* "path" is a Jack file or a directory of them, and the VM files are written
+* to "outDir", by default the server's current directory. The "shutdown"
+* method, or the end of input, stops the server.
+*
+* The server keeps the VM code of every class it has compiled in memory,
+* with the hash of its source. A class whose source has not changed is not
+* compiled again; its VM file is only rewritten if it has been changed or
+* deleted since the server wrote it. Since a class's VM code depends only
+* on its own source, no other state needs to be kept between requests.
+*/
+class CompileServer
+{
+public:
+	CompileServer(const CompilerOptions& options) :m_Options{ options } {}
+	// Answers requests from is on os until shutdown or the end of is.
+	void Run(std::istream& is, std::ostream& os);
+private:
+	// What was last compiled from a Jack file, and the VM file written for it.
+	struct Entry
+	{
+		uint64_t sourceHash = 0;
+		std::string vm;
+		std::string error;
+		std::filesystem::path vmPath;
+		std::filesystem::file_time_type vmTime;
+	};
+	CompilerOptions m_Options;
+	// By absolute path of the Jack file.
+	std::map<std::filesystem::path, Entry> m_Classes;
+
+	// Returns the result of a compile request, or throws std::invalid_argument if its params are wrong.
+	JsonValue Compile(const JsonValue* params);
+	// Compiles the class at path, unless it is in m_Classes with the same source; returns its entry.
+	const Entry& CompileClass(const std::filesystem::path& path, const std::filesystem::path& outDir, bool& compiled);
+};
+} // namespace jack
@@ -0,0 +1,182 @@
+#include <fstream>
+#include <iomanip>
+#include "CompileStats.h"
+#include "Json.h"
+
+namespace jack {
+// Writes counts as a JSON object from name to count.
+static void WriteCounts(std::ostream& os, const std::map<std::string, int, std::less<>>& counts)
+{
+	os << "{";
+	const char* separator = "";
+	for (const auto& count : counts)
+	{
+		os << separator;
+		WriteJsonString(os, count.first);
+		os << ": " << count.second;
+		separator = ", ";
+	}
+	os << "}";
+}
+
+void CompileStats::Add(const std::string& path, const PhaseTimes& times, std::string_view vm)
+{
+	Class cls{ path, times, {} };
+	std::vector<std::string_view> words;
+	while (!vm.empty())
+	{
+		const size_t eol = vm.find('\n');
+		std::string_view line = vm.substr(0, eol);
+		vm.remove_prefix(eol == std::string_view::npos ? vm.size() : eol + 1);
+		words.clear();
+		for (size_t start = line.find_first_not_of(" \t\r"); start != std::string_view::npos;
+			start = line.find_first_not_of(" \t\r", start))
+		{
+			const size_t end = line.find_first_of(" \t\r", start);
+			words.push_back(line.substr(start, end - start));
+			start = end;
+		}
+		if (words.empty() || words[0].substr(0, 2) == "//")
+			continue;
+		if (words[0] == "function" && words.size() > 1)
+		{
+			Subroutine function;
+			function.name = words[1];
+			cls.subroutines.push_back(std::move(function));
+		}
+		else if (cls.subroutines.empty())
+			continue;	// The compiler emits nothing outside a function.
+		Subroutine& sub = cls.subroutines.back();
+		sub.vmCommands++;
+		sub.hackInstructions += HackSize(words);
+		auto opcode = sub.opcodes.find(words[0]);
+		if (opcode == sub.opcodes.end())
+			opcode = sub.opcodes.emplace(std::string{ words[0] }, 0).first;
+		opcode->second++;
+		if (words[0] == "call" && words.size() > 1)
+		{
+			auto callee = sub.calls.find(words[1]);
+			if (callee == sub.calls.end())
+				callee = sub.calls.emplace(std::string{ words[1] }, 0).first;
+			callee->second++;
+		}
+	}
+	m_Classes.push_back(std::move(cls));
+}
+
+// Instructions the VM translator takes to address segment index for the extended VM's commands.
+static int AddressSize(std::string_view segment, int index)
+{
+	if (segment == "static" || segment == "temp" || segment == "pointer")
+		return 1;
+	if (index > 3)
+		return 4;
+	return index == 0 ? 2 : 1 + index;
+}
+
+// Instructions it takes to load segment index into D.
+static int LoadSize(std::string_view segment, int index)
+{
+	return segment == "constant" ? 2 : AddressSize(segment, index) + 1;
+}
+
+static int Index(const std::vector<std::string_view>& words, size_t i)
+{
+	return words.size() > i ? std::stoi(std::string{ words[i] }) : 0;
+}
+
+/*
+* Sizes of the code the VM translator of project 8 emits, without the
+* labels it declares. Only the number of locals changes the size of a
+* function command, and no index changes that of a push or pop; the
+* fused commands of the extended VM are shorter for small indexes. In
+* cold functions, calls, returns and comparisons jump to shared routines.
+*/
+int CompileStats::HackSize(const std::vector<std::string_view>& words, bool outlined)
+{
+	const std::string_view command = words[0];
+	const std::string_view segment = words.size() > 1 ? words[1] : std::string_view{};
+	if (command == "push")
+		return (segment == "constant" || segment == "static") ? 7 : 10;
+	if (command == "pop")
+	{
+		if (segment == "static")
+			return 6;
+		return (segment == "temp" || segment == "pointer") ? 15 : 13;
+	}
+	if (command == "add" || command == "sub" || command == "and" || command == "or")
+		return 10;
+	if (command == "neg" || command == "not")
+		return 6;
+	if (command == "eq" || command == "gt" || command == "lt")
+		return outlined ? 4 : 19;
+	if (command == "goto")
+		return 2;
+	if (command == "if-goto")
+		return 6;
+	if (command.substr(0, 3) == "if-")	// Extended VM comparisons, e.g. if-lt.
+		return 10;
+	if (command == "inc" || command == "dec")
+		return AddressSize(segment, Index(words, 2)) + 1;
+	if (command == "push-add" || command == "push-sub")
+		return (segment == "constant" && Index(words, 2) == 1) ? 3 : LoadSize(segment, Index(words, 2)) + 3;
+	if (command == "move" && words.size() > 4)
+	{
+		const int src_index = Index(words, 2), dst_index = Index(words, 4);
+		if (segment == "constant" && (src_index == 0 || src_index == 1))
+			return AddressSize(words[3], dst_index) + 1;
+		if (words[3] != "static" && words[3] != "temp" && words[3] != "pointer" && dst_index > 3)
+			return 6 + LoadSize(segment, src_index) + 3;
+		return LoadSize(segment, src_index) + AddressSize(words[3], dst_index) + 1;
+	}
+	if (command == "call")
+		return outlined ? 6 : 49;
+	if (command == "function" && words.size() > 2)
+		return 5 * std::stoi(std::string{ words[2] });
+	if (command == "return")
+		return outlined ? 2 : 53;
+	return 0;	// label
+}
+
+bool CompileStats::Save(const std::string& path) const
+{
+	std::ofstream ofs{ path };
+	ofs << std::fixed << std::setprecision(3);
+	ofs << "{\n\"options\": ";
+	WriteJsonString(ofs, m_Options);
+	ofs << ",\n\"classes\": [";
+	const char* class_separator = "\n";
+	for (const Class& cls : m_Classes)
+	{
+		int vm_commands = 0, hack_instructions = 0;
+		for (const Subroutine& sub : cls.subroutines)
+		{
+			vm_commands += sub.vmCommands;
+			hack_instructions += sub.hackInstructions;
+		}
+		ofs << class_separator << "{\"file\": ";
+		WriteJsonString(ofs, cls.path);
+		ofs << ",\n \"times_ms\": {\"tokenize\": " << cls.times.tokenize << ", \"parse\": " << cls.times.parse
+			<< ", \"optimize\": " << cls.times.optimize << ", \"emit\": " << cls.times.emit << "},\n";
+		ofs << " \"vm_commands\": " << vm_commands << ", \"hack_instructions\": " << hack_instructions << ",\n";
+		ofs << " \"subroutines\": [";
+		const char* sub_separator = "\n";
+		for (const Subroutine& sub : cls.subroutines)
+		{
+			ofs << sub_separator << "  {\"name\": ";
+			WriteJsonString(ofs, sub.name);
+			ofs << ", \"vm_commands\": " << sub.vmCommands << ", \"hack_instructions\": " << sub.hackInstructions;
+			ofs << ",\n   \"opcodes\": ";
+			WriteCounts(ofs, sub.opcodes);
+			ofs << ",\n   \"calls\": ";
+			WriteCounts(ofs, sub.calls);
+			ofs << "}";
+			sub_separator = ",\n";
+		}
+		ofs << "]}";
+		class_separator = ",\n";
+	}
+	ofs << "]\n}\n";
+	return static_cast<bool>(ofs);
+}
+} // namespace jack
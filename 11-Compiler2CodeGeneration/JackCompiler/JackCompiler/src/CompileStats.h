@@ -0,0 +1,59 @@
+#pragma once
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jack {
+/* Wall-clock time, in milliseconds, spent in each phase of compiling a class. */
+struct PhaseTimes
+{
+	double tokenize = 0;
+	double parse = 0;
+	double optimize = 0;
+	double emit = 0;
+};
+
+/*
+* Collects, for --stats, what was emitted for each class compiled and how
+* long each phase took, and writes it all as one JSON document:
+*
+*	{"options": "-O1", "classes": [{"file": ..., "times_ms": {...},
+*	  "vm_commands": N, "hack_instructions": N, "subroutines": [
+*	  {"name": "Main.main", "vm_commands": N, "hack_instructions": N,
+*	   "opcodes": {"push": N, ...}, "calls": {"Output.printInt": N, ...}}]}]}
+*
+* Hack instructions are estimated from the VM code alone, with the number
+* of instructions the project 8 VM translator emits for each command.
+*/
+class CompileStats
+{
+public:
+	// options: as recorded with the classes, e.g. "-O1 --pool-strings".
+	explicit CompileStats(const std::string& options) : m_Options{ options } {}
+	// Records the class compiled from the Jack file at path to vm.
+	void Add(const std::string& path, const PhaseTimes& times, std::string_view vm);
+	// Returns whether the JSON file could be written.
+	bool Save(const std::string& path) const;
+	// Hack instructions emitted by the VM translator for a command split into its words, in a cold function if outlined.
+	static int HackSize(const std::vector<std::string_view>& words, bool outlined = false);
+private:
+	struct Subroutine
+	{
+		std::string name;
+		int vmCommands = 0;
+		int hackInstructions = 0;
+		std::map<std::string, int, std::less<>> opcodes;
+		// Number of calls to each callee.
+		std::map<std::string, int, std::less<>> calls;
+	};
+	struct Class
+	{
+		std::string path;
+		PhaseTimes times;
+		std::vector<Subroutine> subroutines;
+	};
+	std::string m_Options;
+	std::vector<Class> m_Classes;
+};
+} // namespace jack
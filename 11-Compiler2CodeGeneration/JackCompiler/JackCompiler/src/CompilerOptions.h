@@ -0,0 +1,34 @@
+#pragma once
+
+namespace jack {
+class Profile;
+
+/* Choices of how Jack classes are compiled, set from the command line. */
+struct CompilerOptions
+{
+	/*
+	* Version of the VM code written for the same source and options. Bump
+	* it with every change to the compiler that changes the code it writes,
+	* so that --incremental builds compile every class again.
+	*/
+	static const int CODE_VERSION = 2;
+
+	// Run the Optimizer's passes over the syntax tree.
+	bool optimize = true;
+	/*
+	* Build each distinct string literal once per class, into a static
+	* variable of its own, and push that string wherever the literal is
+	* used. Every use then shares one String, so this is only right for
+	* programs that neither change nor dispose of literals.
+	*/
+	bool poolStrings = false;
+	// Emit the conditional jumps on comparisons and fused commands that only our VM translator accepts.
+	bool extendedVM = false;
+	/*
+	* Execution counts of a run, if given: calls from hot subroutines inline
+	* larger bodies, and cold subroutines call Math's functions instead of
+	* expanding them in place.
+	*/
+	const Profile* profile = nullptr;
+};
+} // namespace jack
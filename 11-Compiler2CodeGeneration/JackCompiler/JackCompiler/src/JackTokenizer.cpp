@@ -1,5 +1,8 @@
-#include <algorithm>		// std::find
-#include <iterator>			// std::cbegin, std::cend
+#include <algorithm>		// std::fill
+#include <cstdint>
+#include <cstring>			// std::memchr
+#include <iterator>			// std::begin, std::end, std::size
+#include <utility>			// std::move
 #include "JackTokenizer.h"
 #include "JackTokenError.h"
 #include "JackConstants.h"
@@ -13,123 +16,194 @@ const char* const JackTokenizer::s_KWs[] = {
 	jack::RETURN
 };
 
-const char JackTokenizer::s_Syms[] = {
-	'{', '}', '(', ')', '[', ']', '.',
-	',', ';', '+', '-', '*', '/', '&',
-	'|', '<', '>', '=', '~'
-};
-
 const int JackTokenizer::s_MAX_INT = 32767;
 
-JackTokenizer::JackTokenizer(std::ifstream& ifs)
-	:m_Ifs{ ifs } {}
-
-JackTokenizer::~JackTokenizer()
+namespace {
+/* What a character can start, or continue, in Jack source. */
+enum class CharClass : unsigned char
 {
-	if (m_Ifs.is_open())
-		m_Ifs.close();
-}
+	OTHER, SPACE, SYMBOL, SLASH, DIGIT, LETTER, QUOTE
+};
 
-bool JackTokenizer::HasMoreTokens()
+/* Class of each byte, for the lexer to dispatch on with a single load. */
+struct CharClasses
 {
-	char c;
-	while ((c = m_Ifs.peek()) != EOF)
-	{
-		if (isspace(c))
-			m_Ifs.get();
-		else if ((c = m_Ifs.get()) == '/' && m_Ifs.peek() == '/')	// End-of-line comment.
-			m_Ifs.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-		else if (c == '/' && m_Ifs.peek() == '*')					// Multiline/Doc comment.
-		{
-			m_Ifs.get();			// Consume the '*'.
-			char c2 = m_Ifs.get();	// Multiline comment ends with */.
-			while (((c = m_Ifs.get()) != '/' && c != EOF) || c2 != '*')	// Order of || matters.
-				c2 = c;
-			if (c == EOF)
-				throw JackTokenError("Expected '*/'");
-		}
-		else {
-			m_Ifs.putback(c);		// Character from end-of-line comment branch.
-			return true;
-		}
-	}
-	return false;
-}
+	CharClass of[256];
 
-void JackTokenizer::Advance()
-{
-	char c = m_Ifs.get();		// HasMoreTokens() guarantees c is not EOF.
-	m_CurrentToken = c;
-	if (std::find(std::cbegin(s_Syms), std::cend(s_Syms), c) != std::cend(s_Syms))
-		return;
-	else if (isdigit(c))							// Possibly an integer constant
+	constexpr CharClasses() :of{}
 	{
-		while (isdigit(m_Ifs.peek()))
-			m_CurrentToken += m_Ifs.get();
-		if (std::stoi(m_CurrentToken) > s_MAX_INT)
-			throw new JackTokenError("Integer " + m_CurrentToken + " too large");
+		for (const char c : " \t\n\v\f\r")
+			of[static_cast<unsigned char>(c)] = CharClass::SPACE;
+		// Valid Jack symbols; '/' may also start a comment.
+		for (const char c : "{}()[].,;+-*&|<>=~")
+			of[static_cast<unsigned char>(c)] = CharClass::SYMBOL;
+		of[static_cast<unsigned char>('/')] = CharClass::SLASH;
+		for (int c = '0'; c <= '9'; c++)
+			of[c] = CharClass::DIGIT;
+		for (int c = 'a'; c <= 'z'; c++)
+			of[c] = of[c - 'a' + 'A'] = CharClass::LETTER;
+		of[static_cast<unsigned char>('_')] = CharClass::LETTER;
+		of[static_cast<unsigned char>('"')] = CharClass::QUOTE;
+		of[0] = CharClass::OTHER;	// The terminator of the strings above.
 	}
-	else if (c == '"')								// Possibly a string constant.
-	{
-		char c2 = c;
-		while ((c2 == '\\' || (c = m_Ifs.get()) != '"') && c != EOF) {
-			m_CurrentToken += c;					// Allow character escape sequences,
-			c2 = c;									// including \".
-		}
-		if (c2 == EOF)								// Discard closing ".
-			throw JackTokenError("Expected \"");
-	}
-	else if (isalnum(c) || c == '_')				// Identifier (variableName, className..).
-		while ((isalnum(c = m_Ifs.peek()) || c == '_') && c != EOF)
-			m_CurrentToken += (c = m_Ifs.get());
-	else
-		throw JackTokenError("Unexpected " + c);
-}
+	CharClass operator[](char c) const { return of[static_cast<unsigned char>(c)]; }
+};
 
-JackTokenType JackTokenizer::TokenType() const
-{
-	char c = m_CurrentToken[0];
-	if (std::find(std::cbegin(s_Syms), std::cend(s_Syms), c) != std::cend(s_Syms))
-		return JackTokenType::SYMBOL;
-	else if (isdigit(c))
-		return JackTokenType::INT_CONST;
-	else if (c == '"')
-		return JackTokenType::STRING_CONST;
-	else if (std::find(std::cbegin(s_KWs), std::cend(s_KWs), m_CurrentToken) != std::cend(s_KWs))
-		return JackTokenType::KEYWORD;
-	else if (isalnum(c) || c == '_')
-		return JackTokenType::IDENTIFIER;
-	else
-		return JackTokenType::INVALID;
-}
+constexpr CharClasses CHAR_CLASSES;
 
-/* Should only be called if TokenType() == KEYWORD. */
-const std::string JackTokenizer::KeyWord() const
+/*
+* A hash without collisions over the Jack keywords, so that an identifier
+* is compared with one keyword at most.
+*/
+unsigned KeyWordHash(std::string_view text)
 {
-	return m_CurrentToken;
+	return (static_cast<unsigned>(text.size()) + 5u * text.front() + 11u * text.back()) & 63u;
 }
 
-/* Should only be called if TokenType() == SYMBOL. */
-char JackTokenizer::Symbol() const
+// Index into s_KWs of the keyword with each hash, or -1.
+int8_t g_KeyWordByHash[64];
+} // namespace
+
+const JackTokenizer::Token JackTokenizer::s_NO_TOKEN = {
+	0, 0, 0, JackTokenType::INVALID, JackKeyWord::NONE, '\0'
+};
+
+JackTokenizer::JackTokenizer(std::ifstream& ifs)
+	:m_Current{ 0 }, m_Next{ 0 }
 {
-	return m_CurrentToken[0];
+	// Read the whole file with a single read of its size.
+	ifs.seekg(0, std::ios::end);
+	const std::streamoff size = ifs.tellg();
+	ifs.seekg(0, std::ios::beg);
+	if (size > 0)
+	{
+		m_Source.resize(static_cast<size_t>(size));
+		ifs.read(m_Source.data(), size);
+		m_Source.resize(static_cast<size_t>(ifs.gcount()));
+	}
+	ifs.close();
+	Lex();
+	// The current token is only set by the first Advance().
+	m_Current = m_Tokens.size();
 }
 
-/* Should only be called if TokenType() == IDENTIFIER. */
-const std::string JackTokenizer::Identifier() const
+JackTokenizer::JackTokenizer(std::string source)
+	:m_Source{ std::move(source) }, m_Current{ 0 }, m_Next{ 0 }
 {
-	return m_CurrentToken;
+	Lex();
+	m_Current = m_Tokens.size();
 }
 
-/* Should only be called if TokenType() == INT_CONST. */
-int JackTokenizer::IntVal() const
+// Keyword of an identifier-like text, or NONE.
+JackKeyWord JackTokenizer::KeyWordOf(std::string_view text)
 {
-	return std::stoi(m_CurrentToken);
+	static const bool init = []() {
+		std::fill(std::begin(g_KeyWordByHash), std::end(g_KeyWordByHash), -1);
+		for (size_t i = 0; i < std::size(s_KWs); i++)
+			g_KeyWordByHash[KeyWordHash(s_KWs[i])] = static_cast<int8_t>(i);
+		return true;
+	}();
+	(void)init;
+	const int i = g_KeyWordByHash[KeyWordHash(text)];
+	return (i >= 0 && text == s_KWs[i]) ? static_cast<JackKeyWord>(i) : JackKeyWord::NONE;
 }
 
-/* Should only be called if TokenType() == STRING_CONST. */
-const std::string JackTokenizer::StringVal() const
+/*
+* Splits the source into tokens, skipping white space and comments, and
+* classifies each token once.
+*
+* Each token is recognized by the class of its first character, looked up
+* in a table. Runs of comment or string text are skipped with memchr,
+* which the C library implements with vector instructions.
+*/
+void JackTokenizer::Lex()
 {
-	return m_CurrentToken.substr(1); // Omit the opening " (has no ending ").
+	const char* p = m_Source.data();
+	const char* const end = p + m_Source.size();
+	// About one token per 6 bytes of typical Jack source.
+	m_Tokens.reserve(m_Source.size() / 6 + 1);
+	while (p < end)
+	{
+		const char c = *p;
+		const char* start = p;
+		Token token = s_NO_TOKEN;
+		switch (CHAR_CLASSES[c])
+		{
+		case CharClass::SPACE:
+			while (++p < end && CHAR_CLASSES[*p] == CharClass::SPACE)
+				;
+			continue;
+		case CharClass::SLASH:
+			if (p + 1 < end && p[1] == '/')		// End-of-line comment.
+			{
+				p = static_cast<const char*>(std::memchr(p, '\n', end - p));
+				if (!p)
+					p = end;
+				continue;
+			}
+			if (p + 1 < end && p[1] == '*')		// Multiline/Doc comment.
+			{
+				for (p += 2; ; p++)
+				{
+					p = static_cast<const char*>(std::memchr(p, '*', end - p));
+					if (!p || p + 1 == end)
+						throw JackTokenError("Expected '*/'");
+					if (p[1] == '/')
+						break;
+				}
+				p += 2;
+				continue;
+			}
+			[[fallthrough]];	// Division.
+		case CharClass::SYMBOL:
+			token.type = JackTokenType::SYMBOL;
+			token.symbol = c;
+			token.length = 1;
+			p++;
+			break;
+		case CharClass::DIGIT:							// Integer constant.
+		{
+			long value = 0;
+			for (; p < end && CHAR_CLASSES[*p] == CharClass::DIGIT; p++)
+				if ((value = value * 10 + (*p - '0')) > s_MAX_INT)
+					value = s_MAX_INT + 1L;
+			if (value > s_MAX_INT)
+				throw JackTokenError("Integer " + std::string(start, p) + " too large");
+			token.type = JackTokenType::INT_CONST;
+			token.intVal = static_cast<int16_t>(value);
+			token.length = static_cast<uint32_t>(p - start);
+			break;
+		}
+		case CharClass::QUOTE:							// String constant.
+		{
+			start = ++p;
+			const char* close = static_cast<const char*>(std::memchr(p, '"', end - p));
+			if (close && std::memchr(p, '\\', close - p))
+			{	// Allow character escape sequences, including \".
+				for (; p < end && *p != '"'; p++)
+					if (*p == '\\' && p + 1 < end)
+						p++;
+				close = (p < end) ? p : nullptr;
+			}
+			if (!close)
+				throw JackTokenError("Expected \"");
+			p = close + 1;								// Discard closing ".
+			token.type = JackTokenType::STRING_CONST;
+			token.length = static_cast<uint32_t>(close - start);
+			break;
+		}
+		case CharClass::LETTER:							// Keyword or identifier.
+			while (++p < end && (CHAR_CLASSES[*p] == CharClass::LETTER || CHAR_CLASSES[*p] == CharClass::DIGIT))
+				;
+			token.length = static_cast<uint32_t>(p - start);
+			token.keyWord = KeyWordOf(std::string_view(start, p - start));
+			token.type = (token.keyWord == JackKeyWord::NONE) ? JackTokenType::IDENTIFIER : JackTokenType::KEYWORD;
+			break;
+		default:
+			throw JackTokenError(std::string("Unexpected ") + c);
+		}
+		token.offset = static_cast<uint32_t>(start - m_Source.data());
+		m_Tokens.push_back(token);
+	}
 }
-} // namespace jack
\ No newline at end of file
+} // namespace jack
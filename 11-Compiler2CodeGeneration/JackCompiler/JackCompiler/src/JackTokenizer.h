@@ -1,49 +1,91 @@
 #pragma once
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <fstream>
-#include <unordered_set>
+#include <vector>
 
 namespace jack {
 /* Types of Lexical Elements of the Jack programming language. */
-enum class JackTokenType
+enum class JackTokenType : uint8_t
 {
 	KEYWORD, SYMBOL, IDENTIFIER, INT_CONST, STRING_CONST, INVALID
 };
 
+/* Jack keywords, in the order of JackTokenizer::s_KWs. */
+enum class JackKeyWord : uint8_t
+{
+	CLASS, CONSTRUCTOR, FUNCTION, METHOD, FIELD, STATIC, VAR, INT, CHAR,
+	BOOL, VOID, TRUE, FALSE, J_NULL, THIS, LET, DO, IF, ELSE, WHILE,
+	RETURN, NONE
+};
+
 /*
 * The JackTokenizer class parses an input jack source file
 * (with a ".jack" extension) into its terminal elements (tokens).
 * It also ignores white spaces and any valid type of comment.
+*
+* The whole file is read with a single read and lexed up front into a
+* vector of tokens, each already classified, so that the accessors below
+* only read the current token. Token texts view the source; nothing is
+* copied until the compiler keeps a name.
 */
 class JackTokenizer
 {
 public:
-	// Gets file stream ready for parsing.
+	/*
+	* A lexed token, in 16 bytes. Its text is the keyword or identifier, or
+	* the string constant without its quotes, at offset in the tokenizer's
+	* copy of the source.
+	*/
+	struct Token
+	{
+		uint32_t offset;
+		uint32_t length;
+		// INT_CONST only; at most s_MAX_INT.
+		int16_t intVal;
+		JackTokenType type;
+		// KEYWORD only.
+		JackKeyWord keyWord;
+		// SYMBOL only.
+		char symbol;
+	};
+public:
+	// Reads the whole file stream, closes it, and lexes all of its tokens.
 	JackTokenizer(std::ifstream& ifs);
-	~JackTokenizer();
+	// Lexes source text already read, such as a file the caller has hashed.
+	explicit JackTokenizer(std::string source);
 	// Asserts that there is a token to be read (non-comment/white space).
-	bool HasMoreTokens();
+	bool HasMoreTokens() const { return m_Next < m_Tokens.size(); }
 	// Sets the current token in the stream (should call only if HasMoreTokens() is true).
-	void Advance();
-	JackTokenType TokenType() const;
+	void Advance() { m_Current = m_Next++; }
+	JackTokenType TokenType() const { return Current().type; }
 
 	// Returns value of current token (after asserting its type with TokenType()).
-	const std::string KeyWord() const;
-	char Symbol() const;
-	const std::string Identifier() const;
-	int IntVal() const;
-	const std::string StringVal() const;
+	std::string_view KeyWord() const { return Text(Current()); }
+	JackKeyWord KeyWordId() const { return Current().keyWord; }
+	char Symbol() const { return Current().symbol; }
+	std::string_view Identifier() const { return Text(Current()); }
+	int IntVal() const { return Current().intVal; }
+	std::string_view StringVal() const { return Text(Current()); }
 private:
 	// Valid Jack Keywords.
 	static const char* const s_KWs[];
-	// Valid Jack symbols.
-	static const char s_Syms[];
 	// Maximum integer constant in Jack.
 	static const int s_MAX_INT;
+	// Current token before the first call to Advance().
+	static const Token s_NO_TOKEN;
+
+	// Whole source file; tokens view into it.
+	std::string m_Source;
+	std::vector<Token> m_Tokens;
+	// Index of the current token, and of the one Advance() moves to.
+	size_t m_Current;
+	size_t m_Next;
 
-	// Input filestream for the relevant Jack source file.
-	std::ifstream& m_Ifs;
-	// Current Jack token parsed from stream.
-	std::string m_CurrentToken;
+	std::string_view Text(const Token& token) const { return { m_Source.data() + token.offset, token.length }; }
+	static JackKeyWord KeyWordOf(std::string_view text);
+	const Token& Current() const { return m_Current < m_Tokens.size() ? m_Tokens[m_Current] : s_NO_TOKEN; }
+	void Lex();
 };
-} // namespace jack
\ No newline at end of file
+} // namespace jack
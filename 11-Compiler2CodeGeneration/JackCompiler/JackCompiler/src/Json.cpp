@@ -0,0 +1,287 @@
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <stdexcept>
+#include "Json.h"
+
+namespace jack {
+const JsonValue* JsonValue::Find(std::string_view key) const
+{
+	auto it = object.find(key);
+	return it == object.end() ? nullptr : &it->second;
+}
+
+/* Recursive descent over the text of one JSON document. */
+class JsonParser
+{
+public:
+	JsonParser(std::string_view text) :m_Text{ text }, m_Pos{ 0 }, m_Depth{ 0 } {}
+
+	JsonValue ParseDocument()
+	{
+		JsonValue value = ParseValue();
+		SkipSpace();
+		if (m_Pos != m_Text.size())
+			Fail("Unexpected text after value");
+		return value;
+	}
+private:
+	// Deepest nesting of arrays and objects accepted, so that a hostile line cannot overflow the stack.
+	static const int s_MAX_DEPTH = 64;
+	std::string_view m_Text;
+	size_t m_Pos;
+	int m_Depth;
+
+	[[noreturn]] void Fail(const std::string& message) const
+	{
+		throw std::invalid_argument(message + " at offset " + std::to_string(m_Pos));
+	}
+
+	void SkipSpace()
+	{
+		while (m_Pos < m_Text.size() && (m_Text[m_Pos] == ' ' || m_Text[m_Pos] == '\t' ||
+			m_Text[m_Pos] == '\n' || m_Text[m_Pos] == '\r'))
+			m_Pos++;
+	}
+
+	// Consumes c, after any white space, if it is next.
+	bool Accept(char c)
+	{
+		SkipSpace();
+		if (m_Pos < m_Text.size() && m_Text[m_Pos] == c)
+		{
+			m_Pos++;
+			return true;
+		}
+		return false;
+	}
+
+	void Expect(char c)
+	{
+		if (!Accept(c))
+			Fail(std::string{ "Expected " } + c);
+	}
+
+	bool AcceptWord(std::string_view word)
+	{
+		if (m_Text.substr(m_Pos, word.size()) != word)
+			return false;
+		m_Pos += word.size();
+		return true;
+	}
+
+	JsonValue ParseValue()
+	{
+		JsonValue value;
+		SkipSpace();
+		if (m_Pos == m_Text.size())
+			Fail("Expected a value");
+		const char c = m_Text[m_Pos];
+		if ((c == '{' || c == '[') && m_Depth == s_MAX_DEPTH)
+			Fail("Too deeply nested");
+		if (c == '{')
+		{
+			m_Pos++;
+			value.type = JsonValue::Type::OBJECT;
+			if (Accept('}'))
+				return value;
+			m_Depth++;
+			do
+			{
+				SkipSpace();
+				std::string key = ParseString();
+				Expect(':');
+				value.object[key] = ParseValue();
+			} while (Accept(','));
+			Expect('}');
+			m_Depth--;
+		}
+		else if (c == '[')
+		{
+			m_Pos++;
+			value.type = JsonValue::Type::ARRAY;
+			if (Accept(']'))
+				return value;
+			m_Depth++;
+			do
+				value.array.push_back(ParseValue());
+			while (Accept(','));
+			Expect(']');
+			m_Depth--;
+		}
+		else if (c == '"')
+		{
+			value.type = JsonValue::Type::STRING;
+			value.string = ParseString();
+		}
+		else if (AcceptWord("true") || AcceptWord("false"))
+		{
+			value.type = JsonValue::Type::BOOL;
+			value.boolean = (c == 't');
+		}
+		else if (AcceptWord("null"))
+			value.type = JsonValue::Type::NUL;
+		else
+		{
+			value.type = JsonValue::Type::NUMBER;
+			value.number = ParseNumber();
+		}
+		return value;
+	}
+
+	bool AcceptDigits()
+	{
+		const size_t start = m_Pos;
+		while (m_Pos < m_Text.size() && isdigit(static_cast<unsigned char>(m_Text[m_Pos])))
+			m_Pos++;
+		return m_Pos > start;
+	}
+
+	// -? (0 | [1-9][0-9]*) (. [0-9]+)? ([eE] [+-]? [0-9]+)?, which strtod alone would widen to nan, inf, hex and "+".
+	double ParseNumber()
+	{
+		const size_t start = m_Pos;
+		AcceptWord("-");
+		if (!AcceptWord("0") && !AcceptDigits())
+			Fail("Expected a value");
+		if (AcceptWord(".") && !AcceptDigits())
+			Fail("Expected digits after the point");
+		if (AcceptWord("e") || AcceptWord("E"))
+		{
+			if (!AcceptWord("+"))
+				AcceptWord("-");
+			if (!AcceptDigits())
+				Fail("Expected digits in the exponent");
+		}
+		const double number = std::strtod(std::string{ m_Text.substr(start, m_Pos - start) }.c_str(), nullptr);
+		if (!std::isfinite(number))
+			Fail("Number out of range");
+		return number;
+	}
+
+	std::string ParseString()
+	{
+		if (m_Pos == m_Text.size() || m_Text[m_Pos] != '"')
+			Fail("Expected a string");
+		m_Pos++;
+		std::string text;
+		while (m_Pos < m_Text.size() && m_Text[m_Pos] != '"')
+		{
+			char c = m_Text[m_Pos++];
+			if (c != '\\')
+			{
+				text += c;
+				continue;
+			}
+			if (m_Pos == m_Text.size())
+				break;
+			c = m_Text[m_Pos++];
+			switch (c)
+			{
+			case 'b': text += '\b'; break;
+			case 'f': text += '\f'; break;
+			case 'n': text += '\n'; break;
+			case 'r': text += '\r'; break;
+			case 't': text += '\t'; break;
+			case 'u':
+			{	// Code points of the Basic Multilingual Plane, as UTF-8.
+				if (m_Pos + 4 > m_Text.size())
+					Fail("Bad escape");
+				const unsigned long code = std::strtoul(std::string{ m_Text.substr(m_Pos, 4) }.c_str(), nullptr, 16);
+				m_Pos += 4;
+				if (code < 0x80)
+					text += static_cast<char>(code);
+				else if (code < 0x800)
+				{
+					text += static_cast<char>(0xC0 | (code >> 6));
+					text += static_cast<char>(0x80 | (code & 0x3F));
+				}
+				else
+				{
+					text += static_cast<char>(0xE0 | (code >> 12));
+					text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+					text += static_cast<char>(0x80 | (code & 0x3F));
+				}
+				break;
+			}
+			default: text += c; break;	// \" \\ \/
+			}
+		}
+		if (m_Pos == m_Text.size())
+			Fail("Unterminated string");
+		m_Pos++;
+		return text;
+	}
+};
+
+JsonValue ParseJson(std::string_view text)
+{
+	return JsonParser{ text }.ParseDocument();
+}
+
+void WriteJsonString(std::ostream& os, std::string_view text)
+{
+	os << '"';
+	for (char c : text)
+	{
+		if (c == '"' || c == '\\')
+			os << '\\' << c;
+		else if (static_cast<unsigned char>(c) < ' ')
+			os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << +c << std::dec << std::setfill(' ');
+		else
+			os << c;
+	}
+	os << '"';
+}
+
+void WriteJson(std::ostream& os, const JsonValue& value)
+{
+	switch (value.type)
+	{
+	case JsonValue::Type::NUL:
+		os << "null";
+		break;
+	case JsonValue::Type::BOOL:
+		os << (value.boolean ? "true" : "false");
+		break;
+	case JsonValue::Type::NUMBER:
+		if (std::fabs(value.number) < 1e15 && value.number == std::trunc(value.number))
+			os << static_cast<long long>(value.number);	// Request ids, mostly.
+		else
+			os << std::setprecision(17) << value.number << std::setprecision(6);
+		break;
+	case JsonValue::Type::STRING:
+		WriteJsonString(os, value.string);
+		break;
+	case JsonValue::Type::ARRAY:
+	{
+		os << "[";
+		const char* separator = "";
+		for (const JsonValue& element : value.array)
+		{
+			os << separator;
+			WriteJson(os, element);
+			separator = ", ";
+		}
+		os << "]";
+		break;
+	}
+	case JsonValue::Type::OBJECT:
+	{
+		os << "{";
+		const char* separator = "";
+		for (const auto& member : value.object)
+		{
+			os << separator;
+			WriteJsonString(os, member.first);
+			os << ": ";
+			WriteJson(os, member.second);
+			separator = ", ";
+		}
+		os << "}";
+		break;
+	}
+	}
+}
+} // namespace jack
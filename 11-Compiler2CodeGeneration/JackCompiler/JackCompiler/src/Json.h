@@ -0,0 +1,34 @@
+#pragma once
+#include <map>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jack {
+/*
+* A JSON value, as read from the compile server's requests. Only the
+* member of the value's type is set.
+*/
+struct JsonValue
+{
+	enum class Type {
+		NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT
+	};
+	Type type = Type::NUL;
+	bool boolean = false;
+	double number = 0;
+	std::string string;
+	std::vector<JsonValue> array;
+	std::map<std::string, JsonValue, std::less<>> object;
+
+	// Member key of an object, or nullptr if there is none.
+	const JsonValue* Find(std::string_view key) const;
+};
+
+// Parses a whole JSON document; throws std::invalid_argument if it is not valid JSON.
+JsonValue ParseJson(std::string_view text);
+// Writes text as a JSON string literal.
+void WriteJsonString(std::ostream& os, std::string_view text);
+void WriteJson(std::ostream& os, const JsonValue& value);
+} // namespace jack
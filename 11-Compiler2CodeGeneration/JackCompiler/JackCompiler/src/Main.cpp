@@ -4,24 +4,122 @@
 #include <exception>
 #include <filesystem>
 #include <fstream>
+#include <thread>
+#include <future>
+#include <atomic>
+#include <algorithm>
+#include <optional>
+#include <sstream>
+#include <chrono>
+#include <utility>
+#include "BuildCache.h"
+#include "CompileStats.h"
+#include "CompileServer.h"
 #include "CompilationEngine.h"
+#include "Profile.h"
 
 namespace fs = std::filesystem;
 
 const char* const g_SRC_EXT = ".jack";
 const char* const g_TARGET_EXT = ".vm";
+// Build cache kept in the current directory, next to the VM files, by --incremental.
+const char* const g_CACHE_FILE = ".jackcache";
+
+// VM code compiled from one class, and what went wrong, if anything.
+struct CompileResult
+{
+	std::string vm;
+	std::string error;
+	jack::PhaseTimes times;
+};
 
 void Usage(const std::string& programName);
+CompileResult Compile(const fs::path& path, const jack::CompilerOptions& options);
+bool Report(const fs::path& path, const CompileResult& result);
+std::string OptionsKey(const jack::CompilerOptions& options);
 
+/*
+* Compile Jack classes to VM code
+*
+* Input:	A Jack file (.jack extension) or a directory of them, optionally
+*			preceded by -j N to compile N classes at a time, -O0 to
+*			skip optimization, --pool-strings to build each string
+*			literal only once, --extended-vm to branch on
+*			comparisons with if-lt and the like and use fused
+*			commands such as inc and move, --incremental to
+*			compile only classes changed since the last run,
+*			--stats FILE to write what was emitted for each class and
+*			how long it took to FILE as JSON, and --profile FILE to
+*			optimize the program for the emulator's profile of a run;
+*			or --server, without --profile, to
+*			answer compile requests from standard input
+* Output:	A VM file (.vm extension) per class in current directory
+*/
 int main(int argc, char* argv[])
 {
-	if (argc == 1)
+	const std::string program_name = fs::path(argv[0]).stem().string();
+	unsigned jobs = 1;
+	bool incremental = false;
+	std::string stats_path;
+	std::optional<jack::Profile> profile;
+	bool server = false;
+	jack::CompilerOptions options;
+	int arg = 1;
+	try
+	{
+		for (; arg < argc && argv[arg][0] == '-'; arg++)
+		{
+			const std::string option = argv[arg];
+			if (option == "-j" && arg + 1 < argc)
+				jobs = std::max(1, std::stoi(argv[++arg]));
+			else if (option == "-O0")
+				options.optimize = false;
+			else if (option == "--pool-strings")
+				options.poolStrings = true;
+			else if (option == "--extended-vm")
+				options.extendedVM = true;
+			else if (option == "--incremental")
+				incremental = true;
+			else if (option == "--stats" && arg + 1 < argc)
+				stats_path = argv[++arg];
+			else if (option == "--profile" && arg + 1 < argc)
+			{
+				profile.emplace(argv[++arg]);
+				options.profile = &*profile;
+			}
+			else if (option == "--server")
+				server = true;
+			else
+				throw std::invalid_argument(option);
+		}
+	}
+	catch (const std::ifstream::failure& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	catch (const std::exception&)
+	{
+		Usage(program_name);
+		return EXIT_FAILURE;
+	}
+	if (server && profile)
+	{	// Hot functions are chosen for a whole program, not one class at a time.
+		std::cerr << "--server cannot be used with --profile" << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (server && arg == argc)
 	{
-		Usage(fs::path(argv[0]).stem().string());
+		jack::CompileServer{ options }.Run(std::cin, std::cout);
+		return EXIT_SUCCESS;
+	}
+	if (server || arg + 1 != argc)
+	{
+		Usage(program_name);
 		return EXIT_FAILURE;
 	}
 	std::vector<fs::path> abs_file_paths;
-	fs::path prgm_path = fs::absolute(argv[1]);
+	fs::path prgm_path = fs::absolute(argv[arg]);
 	if (fs::is_directory(prgm_path))
 	{	// All Jack files in given directory.
 		for (auto& f : fs::directory_iterator{ prgm_path })
@@ -31,28 +129,167 @@ int main(int argc, char* argv[])
 	else if (fs::is_regular_file(prgm_path) && prgm_path.extension() == g_SRC_EXT)
 		abs_file_paths.push_back(prgm_path);
 	else {
-		Usage(fs::path(argv[0]).stem().string());
+		Usage(program_name);
 		return EXIT_FAILURE;
 	}
-	try 
+	if (profile)
 	{
+		std::vector<std::pair<std::string, std::string>> classes;
 		for (const fs::path& p : abs_file_paths)
 		{
-			std::cout << "Processing " << p.string() << std::endl;
-			const std::string& class_name = p.stem().string();
-			// files closed at end of scope.
-			std::ifstream ifs{ p.string() };
-			std::ofstream ofs{ class_name + g_TARGET_EXT };
-			jack::CompilationEngine engine{ ifs, ofs, class_name};
+			std::ifstream ifs{ p, std::ios::binary };
+			std::ostringstream source;
+			source << ifs.rdbuf();
+			classes.emplace_back(p.stem().string(), source.str());
+		}
+		profile->ChooseHot(classes, options);
+	}
+	std::optional<jack::BuildCache> cache;
+	// Sources of the classes to compile, as hashed by the cache.
+	std::vector<std::string> sources;
+	if (incremental)
+	{
+		cache.emplace(g_CACHE_FILE, OptionsKey(options));
+		std::vector<fs::path> stale;
+		for (const fs::path& p : abs_file_paths)
+		{
+			std::ifstream ifs{ p, std::ios::binary };
+			std::ostringstream source;
+			source << ifs.rdbuf();
+			const std::string class_name = p.stem().string();
+			if (cache->IsFresh(class_name, source.str(), class_name + g_TARGET_EXT))
+				std::cout << "Unchanged " << p.string() << std::endl;
+			else
+			{
+				stale.push_back(p);
+				sources.push_back(source.str());
+			}
+		}
+		abs_file_paths = stale;
+	}
+	std::optional<jack::CompileStats> stats;
+	if (!stats_path.empty())
+		stats.emplace(OptionsKey(options));
+	// Reports the result of the i-th class, and records it in the cache and stats, if any.
+	auto report = [&](size_t i, const CompileResult& result) {
+		const bool ok = Report(abs_file_paths[i], result);
+		if (cache && ok)
+			cache->Update(abs_file_paths[i].stem().string(), sources[i], result.vm);
+		else if (cache)
+			cache->Erase(abs_file_paths[i].stem().string());
+		if (stats && ok)
+			stats->Add(abs_file_paths[i].string(), result.times, result.vm);
+		return ok;
+	};
+	// Writes the cache and stats, if any; returns the exit status.
+	auto finish = [&](bool ok) {
+		if (cache && !cache->Save())
+			std::cerr << "Problem encountered while writing \"" << g_CACHE_FILE << "\"" << std::endl;
+		if (stats && !stats->Save(stats_path))
+			std::cerr << "Problem encountered while writing \"" << stats_path << "\"" << std::endl;
+		return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+	};
+	const size_t n_files = abs_file_paths.size();
+	bool ok = true;
+	if (jobs == 1 || n_files < 2)
+	{
+		for (size_t i = 0; i < n_files && ok; i++)
+			ok = report(i, Compile(abs_file_paths[i], options));
+		return finish(ok);
+	}
+	/*
+	* Classes share nothing while compiling, so each worker takes the next
+	* file not yet taken until none are left. Results are reported in file
+	* order, as a serial run would, and once one fails no more are started.
+	*/
+	std::vector<std::promise<CompileResult>> promises(n_files);
+	std::vector<std::future<CompileResult>> results;
+	for (auto& promise : promises)
+		results.push_back(promise.get_future());
+	std::atomic<size_t> next_file{ 0 };
+	std::atomic<bool> stop{ false };
+	std::vector<std::thread> workers;
+	for (size_t t = 0; t < std::min<size_t>(jobs, n_files); t++)
+		workers.emplace_back([&]() {
+			for (size_t i; !stop && (i = next_file++) < n_files; )
+				promises[i].set_value(Compile(abs_file_paths[i], options));
+		});
+	for (size_t i = 0; i < n_files && ok; i++)
+		ok = report(i, results[i].get());
+	stop = true;
+	for (std::thread& worker : workers)
+		worker.join();
+	return finish(ok);
+}
+
+/*
+* Compiles the class in the Jack file at path to VM code in memory.
+* On error, the result holds only the error: the class is parsed whole
+* before any code is generated, so there is no partial code to keep.
+*/
+CompileResult Compile(const fs::path& path, const jack::CompilerOptions& options)
+{
+	CompileResult result;
+	try
+	{
+		const auto start = std::chrono::steady_clock::now();
+		std::ifstream ifs{ path.string() };
+		// The engine reads and tokenizes the whole file as it is constructed.
+		jack::CompilationEngine engine{ ifs, path.stem().string(), options };
+		const std::chrono::duration<double, std::milli> tokenize = std::chrono::steady_clock::now() - start;
+		try
+		{
 			engine.CompileClass();
 		}
+		catch (const std::exception& e)
+		{
+			result.error = e.what();
+			return result;
+		}
+		result.vm = engine.Output();
+		result.times = engine.Times();
+		result.times.tokenize = tokenize.count();
 	}
-	catch (std::exception& e)
+	catch (const std::exception& e)
 	{
-		std::cerr << e.what() << std::endl;
-		return EXIT_FAILURE;
+		result.error = e.what();
+	}
+	return result;
+}
+
+/*
+* Writes the VM file for the class at path, or reports its error and
+* leaves any VM file of an earlier compile as it was; returns whether the
+* class compiled.
+*/
+bool Report(const fs::path& path, const CompileResult& result)
+{
+	std::cout << "Processing " << path.string() << std::endl;
+	if (!result.error.empty())
+	{
+		std::cerr << result.error << std::endl;
+		return false;
+	}
+	std::ofstream ofs{ path.stem().string() + g_TARGET_EXT };
+	ofs.write(result.vm.data(), result.vm.size());
+	return true;
+}
+
+// The options that change the VM code compiled, as recorded by the build cache.
+std::string OptionsKey(const jack::CompilerOptions& options)
+{
+	std::string key = options.optimize ? "-O1" : "-O0";
+	if (options.poolStrings)
+		key += " --pool-strings";
+	if (options.extendedVM)
+		key += " --extended-vm";
+	if (options.profile)
+	{
+		std::ostringstream hash;
+		hash << std::hex << options.profile->Hash();
+		key += " --profile " + hash.str();
 	}
-	return EXIT_SUCCESS;
+	return key;
 }
 
 /*
@@ -60,8 +297,18 @@ int main(int argc, char* argv[])
 */
 void Usage(const std::string& programName)
 {
-	std::cerr << "Usage: " << programName << " [FILE|DIR]" << std::endl;
-	std::cerr << "Description: Convert input Jack file to XML." << std::endl;
-	std::cerr << "             If directory, convert each Jack file in it to a separate XML file.";
+	std::cerr << "Usage: " << programName << " [-j N] [-O0] [--pool-strings] [--extended-vm] [--incremental] [--stats FILE] [--profile FILE] [FILE|DIR|--server]" << std::endl;
+	std::cerr << "Description: Compile input Jack file to VM code." << std::endl;
+	std::cerr << "             If directory, compile each Jack file in it to a separate VM file." << std::endl;
+	std::cerr << "             With -j, compile up to N files at a time." << std::endl;
+	std::cerr << "             With -O0, do not optimize the syntax tree before generating code." << std::endl;
+	std::cerr << "             With --pool-strings, build each string literal once and share it." << std::endl;
+	std::cerr << "             With --extended-vm, branch with if-lt and the like, and use inc, move and push-add." << std::endl;
+	std::cerr << "             With --incremental, only compile classes changed since the last run." << std::endl;
+	std::cerr << "             With --stats, write VM code counts and compile times of each class to FILE as JSON." << std::endl;
+	std::cerr << "             With --profile, inline more in the functions of the program that save the most" << std::endl;
+	std::cerr << "             cycles of the emulator's --profile-out FILE per word of ROM, as many as fit in" << std::endl;
+	std::cerr << "             32K words, and expand less in the others." << std::endl;
+	std::cerr << "             With --server, answer JSON-RPC compile requests, one per line of standard input.";
 	std::cerr << std::endl;
 }
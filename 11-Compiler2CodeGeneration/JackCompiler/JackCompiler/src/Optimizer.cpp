@@ -0,0 +1,482 @@
+#include <algorithm>		// std::find_if, std::max, std::remove_if
+#include <cstdint>
+#include "Optimizer.h"
+
+namespace jack {
+using ast::Expr;
+using ast::ExprKind;
+using ast::HasCall;
+using ast::Stmt;
+using ast::StmtKind;
+using ast::Var;
+
+// Value of the 16-bit word computed by VM code as a Jack int.
+static int Word(int value)
+{
+	return static_cast<int16_t>(static_cast<uint16_t>(value));
+}
+
+// Whether expr has a value known at compile time, and if so, what it is.
+static bool IsConstant(const Expr& expr, int& value)
+{
+	switch (expr.kind)
+	{
+	case ExprKind::INT:
+		value = expr.value;
+		return true;
+	case ExprKind::TRUE:
+		value = -1;
+		return true;
+	case ExprKind::FALSE:
+	case ExprKind::J_NULL:
+		value = 0;
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Local variables and arguments can only be changed by the subroutine's own let statements.
+static bool IsPrivate(const Var& var)
+{
+	return var.segment == VMWriter::Segment::LOCAL || var.segment == VMWriter::Segment::ARG;
+}
+
+// Whether a and b always compute the same value; calls and strings never do.
+static bool Equal(const Expr& a, const Expr& b)
+{
+	if (a.kind != b.kind)
+		return false;
+	switch (a.kind)
+	{
+	case ExprKind::INT:
+		return a.value == b.value;
+	case ExprKind::TRUE:
+	case ExprKind::FALSE:
+	case ExprKind::J_NULL:
+	case ExprKind::THIS:
+		return true;
+	case ExprKind::VAR:
+		return a.var == b.var;
+	case ExprKind::INDEX:
+		return a.var == b.var && Equal(*a.left, *b.left);
+	case ExprKind::UNARY:
+		return a.op == b.op && Equal(*a.left, *b.left);
+	case ExprKind::BINARY:
+		return a.op == b.op && Equal(*a.left, *b.left) && Equal(*a.right, *b.right);
+	default:
+		return false;
+	}
+}
+
+// Whether the value of expr depends only on constants, local variables and arguments.
+static bool IsStable(const Expr& expr)
+{
+	int value;
+	switch (expr.kind)
+	{
+	case ExprKind::VAR:
+		return IsPrivate(expr.var);
+	case ExprKind::UNARY:
+		return IsStable(*expr.left);
+	case ExprKind::BINARY:
+		return IsStable(*expr.left) && IsStable(*expr.right);
+	default:
+		return IsConstant(expr, value);
+	}
+}
+
+// Number of nodes in expr, counting calls as too many to inline.
+static int Size(const Expr* expr)
+{
+	if (!expr)
+		return 0;
+	if (expr->kind == ExprKind::CALL || expr->kind == ExprKind::STRING)
+		return 1 << 16;
+	return 1 + Size(expr->left) + Size(expr->right);
+}
+
+// Number of reads of argument index in expr.
+static int Uses(const Expr* expr, int index)
+{
+	if (!expr)
+		return 0;
+	if (expr->kind == ExprKind::VAR && expr->var.segment == VMWriter::Segment::ARG && expr->var.index == index)
+		return 1;
+	return Uses(expr->left, index) + Uses(expr->right, index);
+}
+
+// Highest index of an argument read in expr, or -1.
+static int LastArgument(const Expr* expr)
+{
+	if (!expr)
+		return -1;
+	if (expr->kind == ExprKind::VAR && expr->var.segment == VMWriter::Segment::ARG)
+		return expr->var.index;
+	return std::max(LastArgument(expr->left), LastArgument(expr->right));
+}
+
+// Whether expr reads a local variable, which only the subroutine's own frame has.
+static bool ReadsLocal(const Expr* expr)
+{
+	if (!expr)
+		return false;
+	if (expr->kind == ExprKind::VAR && expr->var.segment == VMWriter::Segment::LOCAL)
+		return true;
+	return ReadsLocal(expr->left) || ReadsLocal(expr->right);
+}
+
+// Adds the variables assigned by statements, at any depth, to assigned.
+static void CollectAssigned(const ArenaList<Stmt*>& statements, std::vector<Var>& assigned)
+{
+	for (const Stmt* stmt : statements)
+	{
+		if (stmt->kind == StmtKind::LET && !stmt->index)
+			assigned.push_back(stmt->var);
+		CollectAssigned(stmt->body, assigned);
+		CollectAssigned(stmt->elseBody, assigned);
+	}
+}
+
+// Forgets what is known about var, and about variables known to be copies of it.
+static void Kill(std::vector<std::pair<Var, const Expr*>>& copies, const Var& var)
+{
+	copies.erase(std::remove_if(copies.begin(), copies.end(), [&var](const auto& copy) {
+		return copy.first == var || (copy.second->kind == ExprKind::VAR && copy.second->var == var);
+	}), copies.end());
+}
+
+const int Optimizer::s_MAX_INLINE_NODES = 8;
+const int Optimizer::s_MAX_HOT_INLINE_NODES = 32;
+
+Optimizer::Optimizer(Arena& arena, const Profile* profile)
+	:m_Arena{ arena }, m_Profile{ profile }
+{}
+
+void Optimizer::Run(ast::Class& cls)
+{
+	FindInlinable(cls);
+	for (ast::Subroutine* sub : cls.subroutines)
+	{
+		m_Caller = sub->name;
+		InlineCalls(sub->body);
+	}
+	for (ast::Subroutine* sub : cls.subroutines)
+	{
+		FoldConstants(sub->body);
+		Copies copies;
+		PropagateCopies(sub->body, copies);
+		EliminateDeadBranches(sub->body);
+		ReuseArrayElements(sub->body);
+	}
+}
+
+/*
+* A function or method can be inlined if all it does is return a small
+* expression without calls. Constructors cannot, as they allocate, nor can
+* a body that reads a local, which would become the caller's. With a
+* profile, bodies up to the hot limit are kept, for Inline to check where
+* they are called from.
+*/
+void Optimizer::FindInlinable(const ast::Class& cls)
+{
+	for (const ast::Subroutine* sub : cls.subroutines)
+	{
+		if (sub->kind == JackKeyWord::CONSTRUCTOR || sub->body.size != 1)
+			continue;
+		const Stmt& stmt = *sub->body[0];
+		const int max_nodes = m_Profile ? s_MAX_HOT_INLINE_NODES : s_MAX_INLINE_NODES;
+		if (stmt.kind == StmtKind::RETURN && stmt.expr && Size(stmt.expr) <= max_nodes && !ReadsLocal(stmt.expr))
+			m_Inlinable[sub->name] = sub;
+	}
+}
+
+void Optimizer::InlineCalls(ArenaList<Stmt*>& statements)
+{
+	for (Stmt* stmt : statements)
+	{
+		stmt->index = Inline(stmt->index);
+		if (stmt->kind == StmtKind::DO)
+		{	// The call itself stays, as its value is discarded.
+			for (Expr*& arg : stmt->expr->args)
+				arg = Inline(arg);
+			if (stmt->expr->left)
+				stmt->expr->left = Inline(stmt->expr->left);
+		}
+		else
+			stmt->expr = Inline(stmt->expr);
+		InlineCalls(stmt->body);
+		InlineCalls(stmt->elseBody);
+	}
+}
+
+/*
+* The callee calls nothing, so its arguments can be computed in any order,
+* or not at all, as long as they call nothing either. An argument used
+* more than once must be a leaf, so that inlining does not repeat work.
+* A method runs on the same object only when called as "f()" from another
+* method, so that its fields are the caller's. A body larger than the
+* usual limit is only copied into hot callers that the profile saw call
+* it, spending ROM where the cycles are spent.
+*/
+Expr* Optimizer::Inline(Expr* expr)
+{
+	if (!expr)
+		return nullptr;
+	expr->left = Inline(expr->left);
+	expr->right = Inline(expr->right);
+	for (Expr*& arg : expr->args)
+		arg = Inline(arg);
+	if (expr->kind != ExprKind::CALL)
+		return expr;
+	auto it = m_Inlinable.find(expr->text);
+	if (it == m_Inlinable.end())
+		return expr;
+	const ast::Subroutine& callee = *it->second;
+	const int first = (callee.kind == JackKeyWord::METHOD) ? 1 : 0;
+	if (first && !(expr->left && expr->left->kind == ExprKind::THIS))
+		return expr;
+	if (!first && expr->left)
+		return expr;
+	const Expr& body = *callee.body[0]->expr;
+	if (Size(&body) > s_MAX_INLINE_NODES &&
+		!(m_Profile->IsHot(m_Caller) && m_Profile->Calls(m_Caller, callee.name) > 0))
+		return expr;
+	for (size_t i = 0; i < expr->args.size; i++)
+	{
+		const Expr& arg = *expr->args[i];
+		if (HasCall(&arg) || arg.kind == ExprKind::STRING)
+			return expr;
+		if (arg.left && Uses(&body, static_cast<int>(i) + first) > 1)
+			return expr;
+	}
+	if (LastArgument(&body) >= first + static_cast<int>(expr->args.size))
+		return expr;	// An argument was not passed.
+	return Instantiate(body, &expr->args, first);
+}
+
+Expr* Optimizer::Instantiate(const Expr& body, const ArenaList<Expr*>* args, int first)
+{
+	if (args && body.kind == ExprKind::VAR && body.var.segment == VMWriter::Segment::ARG && body.var.index >= first)
+		return Instantiate(*(*args)[body.var.index - first], nullptr, 0);
+	Expr* copy = Clone(body);
+	copy->reuseThat = false;
+	if (body.left)
+		copy->left = Instantiate(*body.left, args, first);
+	if (body.right)
+		copy->right = Instantiate(*body.right, args, first);
+	return copy;
+}
+
+void Optimizer::FoldConstants(ArenaList<Stmt*>& statements)
+{
+	for (Stmt* stmt : statements)
+	{
+		stmt->index = Fold(stmt->index);
+		stmt->expr = Fold(stmt->expr);
+		FoldConstants(stmt->body);
+		FoldConstants(stmt->elseBody);
+	}
+}
+
+/*
+* Returns expr with its constant subexpressions evaluated. Comparisons are
+* made the way the VM translator makes them, by the sign of the 16-bit
+* difference, and divisions that Math.divide would get wrong are left alone.
+*/
+Expr* Optimizer::Fold(Expr* expr)
+{
+	if (!expr)
+		return nullptr;
+	expr->left = Fold(expr->left);
+	expr->right = Fold(expr->right);
+	for (Expr*& arg : expr->args)
+		arg = Fold(arg);
+	int x, y;
+	if (expr->kind == ExprKind::UNARY && IsConstant(*expr->left, x))
+		return NewInt(Word(expr->op == '-' ? -x : ~x));
+	if (expr->kind != ExprKind::BINARY)
+		return expr;
+	const bool left_constant = IsConstant(*expr->left, x);
+	const bool right_constant = IsConstant(*expr->right, y);
+	if (left_constant && right_constant)
+	{
+		switch (expr->op)
+		{
+		case '+': return NewInt(Word(x + y));
+		case '-': return NewInt(Word(x - y));
+		case '*': return NewInt(Word(x * y));
+		case '&': return NewInt(x & y);
+		case '|': return NewInt(x | y);
+		case '<': return NewInt(Word(x - y) < 0 ? -1 : 0);
+		case '>': return NewInt(Word(x - y) > 0 ? -1 : 0);
+		case '=': return NewInt(x == y ? -1 : 0);
+		case '/':
+			if (y != 0 && x != -32768 && y != -32768)
+				return NewInt(x / y);
+			return expr;
+		}
+	}
+	// Identities that leave the other operand's value, and any calls in it, unchanged.
+	if (right_constant && ((y == 0 && (expr->op == '+' || expr->op == '-')) || (y == 1 && expr->op == '*')))
+		return expr->left;
+	if (left_constant && ((x == 0 && expr->op == '+') || (x == 1 && expr->op == '*')))
+		return expr->right;
+	return expr;
+}
+
+/*
+* Walks statements in order, keeping in copies what is known to be held
+* by local variables and arguments. Calls cannot change these, so only
+* let statements end what is known. Knowledge after an if is what holds
+* after both of its branches; a while loop forgets everything its body
+* assigns, both inside and after the loop.
+*/
+void Optimizer::PropagateCopies(ArenaList<Stmt*>& statements, Copies& copies)
+{
+	for (Stmt* stmt : statements)
+	{
+		switch (stmt->kind)
+		{
+		case StmtKind::LET:
+		{
+			stmt->index = Fold(Substitute(stmt->index, copies));
+			stmt->expr = Fold(Substitute(stmt->expr, copies));
+			if (stmt->index)
+				break;
+			Kill(copies, stmt->var);
+			int value;
+			const Expr& source = *stmt->expr;
+			if (IsPrivate(stmt->var) && (IsConstant(source, value) ||
+				(source.kind == ExprKind::VAR && IsPrivate(source.var) && source.var != stmt->var)))
+				copies.push_back({ stmt->var, &source });
+			break;
+		}
+		case StmtKind::IF:
+		{
+			stmt->expr = Fold(Substitute(stmt->expr, copies));
+			Copies else_copies = copies;
+			PropagateCopies(stmt->body, copies);
+			PropagateCopies(stmt->elseBody, else_copies);
+			copies.erase(std::remove_if(copies.begin(), copies.end(), [&else_copies](const auto& copy) {
+				return std::find_if(else_copies.begin(), else_copies.end(), [&copy](const auto& other) {
+					return other.first == copy.first && Equal(*other.second, *copy.second);
+				}) == else_copies.end();
+			}), copies.end());
+			break;
+		}
+		case StmtKind::WHILE:
+		{
+			std::vector<Var> assigned;
+			CollectAssigned(stmt->body, assigned);
+			for (const Var& var : assigned)
+				Kill(copies, var);
+			stmt->expr = Fold(Substitute(stmt->expr, copies));
+			Copies body_copies = copies;
+			PropagateCopies(stmt->body, body_copies);
+			break;
+		}
+		case StmtKind::DO:
+		case StmtKind::RETURN:
+			stmt->expr = Fold(Substitute(stmt->expr, copies));
+			break;
+		}
+	}
+}
+
+// Returns expr with reads of variables in copies replaced by what they hold.
+Expr* Optimizer::Substitute(Expr* expr, const Copies& copies)
+{
+	if (!expr)
+		return nullptr;
+	if (expr->kind == ExprKind::VAR)
+	{
+		auto it = std::find_if(copies.begin(), copies.end(), [expr](const auto& copy) { return copy.first == expr->var; });
+		return it == copies.end() ? expr : Clone(*it->second);
+	}
+	expr->left = Substitute(expr->left, copies);
+	expr->right = Substitute(expr->right, copies);
+	for (Expr*& arg : expr->args)
+		arg = Substitute(arg, copies);
+	return expr;
+}
+
+/*
+* An if or while runs its body only when its condition is true (-1): the
+* VM code branches on the condition's "not", which is only 0 for -1.
+*/
+void Optimizer::EliminateDeadBranches(ArenaList<Stmt*>& statements)
+{
+	std::vector<Stmt*> live;
+	bool changed = false;
+	for (Stmt* stmt : statements)
+	{
+		EliminateDeadBranches(stmt->body);
+		EliminateDeadBranches(stmt->elseBody);
+		int value;
+		if (stmt->kind == StmtKind::IF && IsConstant(*stmt->expr, value))
+		{
+			const ArenaList<Stmt*>& taken = (value == -1) ? stmt->body : stmt->elseBody;
+			live.insert(live.end(), taken.begin(), taken.end());
+			changed = true;
+		}
+		else if (stmt->kind == StmtKind::WHILE && IsConstant(*stmt->expr, value) && value != -1)
+			changed = true;
+		else
+			live.push_back(stmt);
+		// Nothing after a return runs.
+		if (!live.empty() && live.back()->kind == StmtKind::RETURN)
+		{
+			changed = changed || stmt != statements.end()[-1];
+			break;
+		}
+	}
+	if (changed)
+		statements = m_Arena.List(live);
+}
+
+/*
+* The let statement "let a[i] = value" points THAT at a[i] before it
+* computes value, and nothing in value changes THAT for long: other array
+* reads restore it, and callees return with the caller's THAT. So a read
+* of a[i] in value can use THAT as it is, provided a and i are still what
+* they were, which holds if they are local variables, arguments or
+* constants, or value calls nothing that could change them.
+*/
+void Optimizer::ReuseArrayElements(ArenaList<Stmt*>& statements)
+{
+	for (Stmt* stmt : statements)
+	{
+		if (stmt->kind == StmtKind::LET && stmt->index && IsStable(*stmt->index) &&
+			(IsPrivate(stmt->var) || !HasCall(stmt->expr)))
+			MarkArrayElement(stmt->expr, stmt->var, *stmt->index);
+		ReuseArrayElements(stmt->body);
+		ReuseArrayElements(stmt->elseBody);
+	}
+}
+
+void Optimizer::MarkArrayElement(Expr* expr, const Var& array, const Expr& index)
+{
+	if (!expr)
+		return;
+	if (expr->kind == ExprKind::INDEX && expr->var == array && Equal(*expr->left, index))
+	{
+		expr->reuseThat = true;
+		return;
+	}
+	MarkArrayElement(expr->left, array, index);
+	MarkArrayElement(expr->right, array, index);
+	for (Expr* arg : expr->args)
+		MarkArrayElement(arg, array, index);
+}
+
+Expr* Optimizer::NewInt(int value)
+{
+	return m_Arena.New<Expr>(Expr{ ExprKind::INT, value, '\0', {}, {}, nullptr, nullptr, {}, false });
+}
+
+Expr* Optimizer::Clone(const Expr& leaf)
+{
+	return m_Arena.New<Expr>(leaf);
+}
+} // namespace jack
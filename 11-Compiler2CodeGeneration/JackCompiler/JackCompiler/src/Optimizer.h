@@ -0,0 +1,72 @@
+#pragma once
+#include <map>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Arena.h"
+#include "Ast.h"
+#include "Profile.h"
+
+namespace jack {
+/*
+* Rewrites the syntax tree of a class with passes that keep its behavior
+* on the Hack platform but cost fewer VM commands:
+*
+* - Inlining replaces calls to the class's own small functions, and to its
+*   small methods on the same object, whose body only returns an
+*   expression without calls, by that expression with the arguments
+*   substituted. Classes are compiled one at a time, so only subroutines
+*   of the class being compiled can be inlined. Given a profile, hot
+*   subroutines also inline larger bodies of the ones they called.
+* - Constant folding evaluates operators on constants at compile time,
+*   with the same 16-bit results as the VM code would compute.
+* - Copy propagation replaces reads of a local variable or argument by
+*   the constant or other variable last assigned to it, while neither has
+*   been assigned since.
+* - Dead-branch elimination keeps only the branch of an if that runs when
+*   its condition is constant, drops while loops that never run, and drops
+*   statements after a return.
+* - Array element reuse marks reads of a[i] within "let a[i] = ..." so
+*   that they read through the THAT pointer the let has already set.
+*/
+class Optimizer
+{
+public:
+	// profile: execution counts to inline for, or nullptr.
+	Optimizer(Arena& arena, const Profile* profile = nullptr);
+	void Run(ast::Class& cls);
+private:
+	// Variables known to hold a constant or the value of another variable.
+	using Copies = std::vector<std::pair<ast::Var, const ast::Expr*>>;
+
+	// Largest expression, in nodes, that a call is replaced by.
+	static const int s_MAX_INLINE_NODES;
+	// Largest, from a hot subroutine that the profile saw make the call.
+	static const int s_MAX_HOT_INLINE_NODES;
+
+	// Allocates the nodes the passes create.
+	Arena& m_Arena;
+	const Profile* m_Profile;
+	// Full name of the subroutine whose calls are being inlined.
+	std::string_view m_Caller;
+	// Subroutines whose calls are inlined, by full name.
+	std::map<std::string_view, const ast::Subroutine*> m_Inlinable;
+
+	void FindInlinable(const ast::Class& cls);
+	void InlineCalls(ArenaList<ast::Stmt*>& statements);
+	ast::Expr* Inline(ast::Expr* expr);
+	// Copies body with the callee's argument i replaced by a copy of (*args)[i - first], if args.
+	ast::Expr* Instantiate(const ast::Expr& body, const ArenaList<ast::Expr*>* args, int first);
+	void FoldConstants(ArenaList<ast::Stmt*>& statements);
+	ast::Expr* Fold(ast::Expr* expr);
+	void PropagateCopies(ArenaList<ast::Stmt*>& statements, Copies& copies);
+	ast::Expr* Substitute(ast::Expr* expr, const Copies& copies);
+	void EliminateDeadBranches(ArenaList<ast::Stmt*>& statements);
+	void ReuseArrayElements(ArenaList<ast::Stmt*>& statements);
+	void MarkArrayElement(ast::Expr* expr, const ast::Var& array, const ast::Expr& index);
+
+	ast::Expr* NewInt(int value);
+	// Copies a leaf node, so that no node is shared between two places in the tree.
+	ast::Expr* Clone(const ast::Expr& leaf);
+};
+} // namespace jack
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include "BuildCache.h"
+#include "CompilationEngine.h"
+#include "CompileStats.h"
+#include "Profile.h"
+
+namespace jack {
+/*
+* Words of the code the VM translator of project 8 writes once for the
+* whole program: the bootstrap, with Sys.init's call inline, and each
+* shared routine that cold functions jump to, for calls with a number of
+* arguments, for returns, and for each of eq, gt and lt.
+*/
+static const int BOOTSTRAP_WORDS = 53;
+static const int CALL_ROUTINE_WORDS = 52;
+static const int RETURN_ROUTINE_WORDS = 49;
+static const int COMPARE_ROUTINE_WORDS = 22;
+
+Profile::Profile(const std::string& path)
+{
+	std::ifstream ifs{ path, std::ios::binary };
+	if (!ifs)
+		throw std::ifstream::failure("Problem encountered while opening \"" + path + "\"");
+	std::ostringstream text;
+	text << ifs.rdbuf();
+	m_TextHash = m_Hash = BuildCache::Hash(text.str());
+	std::istringstream lines{ text.str() };
+	std::string line;
+	while (std::getline(lines, line))
+	{
+		std::istringstream iss{ line };
+		std::string kind, name, callee;
+		uint64_t calls, cycles;
+		iss >> kind;
+		if (kind == "function" && iss >> name >> calls >> cycles)
+			m_Cycles[name] += cycles;
+		else if (kind == "call" && iss >> name >> callee >> calls)
+			m_Calls[{ name, callee }] += calls;
+	}
+}
+
+// Adds the words the VM translator writes for each function of vm to words, and each call's number of arguments to callArgs.
+static void AddWords(const std::string& vm, bool outlined, std::map<std::string, int>& words, std::set<int>& callArgs)
+{
+	std::istringstream lines{ vm };
+	std::string line, function;
+	while (std::getline(lines, line))
+	{
+		std::istringstream iss{ line };
+		const std::vector<std::string> text{ std::istream_iterator<std::string>{ iss }, {} };
+		if (text.empty())
+			continue;
+		if (text[0] == "function" && text.size() > 1)
+			function = text[1];
+		else if (text[0] == "call" && text.size() > 2)
+			callArgs.insert(std::stoi(text[2]));
+		words[function] += CompileStats::HackSize({ text.begin(), text.end() }, outlined);
+	}
+}
+
+/*
+* Each class is compiled twice, with every function cold and with every
+* function that ran hot, and the words of each function are estimated as
+* CompileStats does. Then, in order of their own cycles per word that
+* their hot code adds, functions are made hot for as long as they fit in
+* what the cold program leaves of the ROM. A function's hotness changes
+* only its own code, so the words each adds do not depend on the others.
+* A class that does not compile is left out; compiling it reports why.
+*/
+void Profile::ChooseHot(const std::vector<std::pair<std::string, std::string>>& classes,
+	const CompilerOptions& options)
+{
+	Profile cold{ *this }, hot{ *this };
+	cold.m_Hot.clear();
+	hot.m_Hot.clear();
+	for (const auto& function : m_Cycles)
+		hot.m_Hot.insert(function.first);
+	std::map<std::string, int> cold_words, hot_words;
+	std::set<int> call_args;
+	for (const auto& [class_name, source] : classes)
+	{
+		CompilerOptions cold_options = options, hot_options = options;
+		cold_options.profile = &cold;
+		hot_options.profile = &hot;
+		try
+		{
+			CompilationEngine cold_engine{ source, class_name, cold_options };
+			cold_engine.CompileClass();
+			CompilationEngine hot_engine{ source, class_name, hot_options };
+			hot_engine.CompileClass();
+			AddWords(cold_engine.Output(), true, cold_words, call_args);
+			AddWords(hot_engine.Output(), false, hot_words, call_args);
+		}
+		catch (const std::exception&)
+		{
+		}
+	}
+	long long free_words = ROM_WORDS - BOOTSTRAP_WORDS - RETURN_ROUTINE_WORDS - 3 * COMPARE_ROUTINE_WORDS -
+		CALL_ROUTINE_WORDS * static_cast<long long>(call_args.size());
+	struct Candidate
+	{
+		std::string name;
+		uint64_t cycles;
+		long long words;
+	};
+	std::vector<Candidate> candidates;
+	for (const auto& [name, words] : cold_words)
+	{
+		free_words -= words;
+		auto cycles = m_Cycles.find(name);
+		if (cycles != m_Cycles.end() && cycles->second > 0)
+			candidates.push_back({ name, cycles->second, std::max(0, hot_words[name] - words) });
+	}
+	// Most cycles per word first, and by name among equals.
+	std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+		if (a.cycles * b.words != b.cycles * a.words)
+			return a.cycles * b.words > b.cycles * a.words;
+		return a.name < b.name;
+	});
+	m_Hot.clear();
+	std::string hot_names;
+	for (const Candidate& candidate : candidates)
+		if (candidate.words <= free_words)
+		{
+			m_Hot.insert(candidate.name);
+			free_words -= candidate.words;
+		}
+	for (const std::string& name : m_Hot)
+		hot_names += " " + name;
+	m_Hash = BuildCache::Hash(std::to_string(m_TextHash) + hot_names);
+}
+
+uint64_t Profile::Calls(std::string_view caller, std::string_view callee) const
+{
+	auto it = m_Calls.find(std::pair<std::string, std::string>{ caller, callee });
+	return it == m_Calls.end() ? 0 : it->second;
+}
+} // namespace jack
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "CompilerOptions.h"
+
+namespace jack {
+/*
+* Execution counts of a run of the program, as written by the emulator
+* with --profile-out:
+*
+*	total CYCLES
+*	function NAME CALLS CYCLES
+*	call CALLER CALLEE CALLS
+*
+* Hot functions get code that takes fewer cycles but more of the ROM_WORDS
+* words of ROM, so the hot ones are chosen for the whole program at once,
+* by ChooseHot. Until then, every function is cold; one the profile does
+* not list never ran, and is always cold. The VM translator chooses its
+* own hot functions the same way, from the VM code it is given.
+*/
+class Profile
+{
+public:
+	// Number of instructions the Hack ROM holds.
+	static const int ROM_WORDS = 32768;
+
+	// Loads the profile at path; throws std::ifstream::failure if it cannot be read.
+	explicit Profile(const std::string& path);
+	/*
+	* Makes hot the functions that save the most cycles per word of ROM in
+	* the program made of classes, given as (class name, source) pairs, and
+	* compiled with options.
+	*/
+	void ChooseHot(const std::vector<std::pair<std::string, std::string>>& classes,
+		const CompilerOptions& options);
+	bool IsHot(std::string_view function) const { return m_Hot.find(function) != m_Hot.end(); }
+	// Number of calls the profiled run made from caller to callee.
+	uint64_t Calls(std::string_view caller, std::string_view callee) const;
+	// Hash of the profile's text and of the hot functions, so that a build cache can tell profiles apart.
+	uint64_t Hash() const { return m_Hash; }
+private:
+	// Cycles of each function, by name.
+	std::map<std::string, uint64_t, std::less<>> m_Cycles;
+	// Calls from caller to callee, by their names.
+	std::map<std::pair<std::string, std::string>, uint64_t> m_Calls;
+	std::set<std::string, std::less<>> m_Hot;
+	uint64_t m_TextHash;
+	uint64_t m_Hash;
+};
+} // namespace jack
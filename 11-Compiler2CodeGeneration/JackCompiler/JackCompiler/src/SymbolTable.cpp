@@ -1,59 +1,69 @@
-#include <algorithm>		// std::count_if
 #include "SymbolTable.h"
 #include "JackIdentifierError.h"
 
 namespace jack {
+SymbolTable::SymbolTable()
+	:m_Counts{ 0, 0, 0, 0 }
+{
+}
+
 void SymbolTable::StartSubroutine()
 {
-	m_FuncST.clear();
+	m_FuncST.clear();	// Keeps its capacity.
+	m_Counts[static_cast<int>(Kind::ARG)] = 0;
+	m_Counts[static_cast<int>(Kind::VAR)] = 0;
 }
 
-void SymbolTable::Define(const std::string& name, const std::string& type, Kind kind)
+void SymbolTable::Define(std::string_view name, std::string_view type, Kind kind)
 {
 	if (kind == Kind::NONE)
-		throw JackIdentifierError(name);
-	std::unordered_map<std::string, STEntry>& st =
-		(kind == Kind::ARG || kind == Kind::VAR) ? m_FuncST : m_ClassST;
+		throw JackIdentifierError(std::string(name));
+	std::vector<Entry>& st = (kind == Kind::ARG || kind == Kind::VAR) ? m_FuncST : m_ClassST;
+	const int id = Intern(name);
 	// Verify identifier does not already exist.
-	if (st.find(name) == st.end())
-		st.insert({ name, {kind, type, VarCount(kind)} });
+	if (Find(st, id))
+		return;
+	st.push_back({ id, Intern(type), kind, m_Counts[static_cast<int>(kind)]++ });
 }
 
 int SymbolTable::VarCount(Kind kind) const
 {
 	if (kind == Kind::NONE)
 		throw JackIdentifierError("Invalid Identifier");
-	const std::unordered_map<std::string, STEntry>& st =
-		(kind == Kind::ARG || kind == Kind::VAR) ? m_FuncST : m_ClassST;
-	// Lambda function in third argument compares by 'kind'.
-	return std::count_if(st.begin(), st.end(),
-		[&kind](const std::pair<std::string, STEntry>& p) {return p.second.kind == kind; });
+	return m_Counts[static_cast<int>(kind)];
+}
+
+const SymbolTable::Entry* SymbolTable::Lookup(std::string_view name) const
+{
+	const int id = IdOf(name);
+	if (id == NO_ID)
+		return nullptr;
+	const Entry* entry = Find(m_FuncST, id);
+	return entry ? entry : Find(m_ClassST, id);
 }
 
-SymbolTable::Kind SymbolTable::KindOf(const std::string& name) const
+int SymbolTable::Intern(std::string_view text)
 {
-	std::unordered_map<std::string, STEntry>::const_iterator it;
-	if ((it = m_FuncST.find(name)) == m_FuncST.end())
-		if ((it = m_ClassST.find(name)) == m_ClassST.end())
-			return Kind::NONE;
-	return it->second.kind;
+	auto it = m_Ids.find(text);
+	if (it != m_Ids.end())
+		return it->second;
+	const int id = static_cast<int>(m_Strings.size());
+	m_Strings.emplace_back(text);
+	m_Ids.emplace(m_Strings.back(), id);
+	return id;
 }
 
-const std::string SymbolTable::TypeOf(const std::string& name) const
+int SymbolTable::IdOf(std::string_view text) const
 {
-	std::unordered_map<std::string, STEntry>::const_iterator it;
-	if ((it = m_FuncST.find(name)) == m_FuncST.end())
-		if ((it = m_ClassST.find(name)) == m_ClassST.end())
-			return "";
-	return it->second.type;
+	auto it = m_Ids.find(text);
+	return (it == m_Ids.end()) ? NO_ID : it->second;
 }
 
-int SymbolTable::IndexOf(const std::string& name) const
+const SymbolTable::Entry* SymbolTable::Find(const std::vector<Entry>& st, int name)
 {
-	std::unordered_map<std::string, STEntry>::const_iterator it;
-	if ((it = m_FuncST.find(name)) == m_FuncST.end())
-		if ((it = m_ClassST.find(name)) == m_ClassST.end())
-			return -1;
-	return it->second.index;
+	for (const Entry& entry : st)
+		if (entry.name == name)
+			return &entry;
+	return nullptr;
 }
-} // namespace jack
\ No newline at end of file
+} // namespace jack
@@ -1,6 +1,9 @@
 #pragma once
+#include <deque>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 namespace jack {
 
@@ -11,6 +14,12 @@ namespace jack {
 * - Kind
 * - Running Index
 * The symbol table for Jack programs has two nested scopes (class/subroutine)
+*
+* Names and types are interned: each distinct string is stored once and
+* known by its id, so an entry is a few integers and the scopes are small
+* vectors searched by id. A name is hashed once per lookup, which returns
+* the whole entry, and the subroutine scope keeps its storage from one
+* subroutine to the next.
 */
 
 class SymbolTable
@@ -20,27 +29,37 @@ public:
 	enum class Kind {
 		STATIC, FIELD, ARG, VAR, NONE
 	};
+	struct Entry {
+		int name;
+		int type;
+		Kind kind;
+		int index;
+	};
 public:
-	// Clears the symbol table.
+	SymbolTable();
+	// Clears the subroutine scope.
 	void StartSubroutine();
-	void Define(const std::string& name, const std::string& type, Kind kind);
+	// Adds name to its kind's scope, unless it is already there.
+	void Define(std::string_view name, std::string_view type, Kind kind);
 	// Number of variables in symbol table of given kind.
 	int VarCount(Kind kind) const;
-	// Returns kind (scope) of identifier 'name' in symbol table, or NONE.
-	Kind KindOf(const std::string& name) const;
-	// Returns the type of identifier 'name' in symbol table.
-	const std::string TypeOf(const std::string& name) const;
-	// Returns the index of identifier 'name' in symbol table.
-	int IndexOf(const std::string& name) const;
+	// Entry of identifier 'name', the subroutine's own first, or nullptr if there is none.
+	const Entry* Lookup(std::string_view name) const;
+	const std::string& TypeOf(const Entry& entry) const { return m_Strings[entry.type]; }
 private:
-	struct STEntry {
-		Kind kind;
-		const std::string type;
-		int index;
-	};
+	static const int NO_ID = -1;
+	// Interned strings by id; a deque, so that the views in m_Ids stay valid.
+	std::deque<std::string> m_Strings;
+	std::unordered_map<std::string_view, int> m_Ids;
 	// STATIC identifiers and class FIELDs.
-	std::unordered_map<std::string, STEntry> m_ClassST;
+	std::vector<Entry> m_ClassST;
 	// Local (VAR) variables and ARGs.
-	std::unordered_map<std::string, STEntry> m_FuncST;
+	std::vector<Entry> m_FuncST;
+	// Number of entries of each kind but NONE.
+	int m_Counts[4];
+
+	int Intern(std::string_view text);
+	int IdOf(std::string_view text) const;
+	static const Entry* Find(const std::vector<Entry>& st, int name);
 };
 } // namespace jack
@@ -1,9 +1,21 @@
+#include <charconv>			// std::to_chars
 #include "VMWriter.h"
 
 namespace jack {
+// Initial buffer capacity; enough for the VM code of most classes.
+static const size_t BUFFER_RESERVE = 64 * 1024;
 
 VMWriter::VMWriter(std::ofstream& ofs)
-	:m_Ofs(ofs) {}
+	:m_Ofs(&ofs)
+{
+	m_Buffer.reserve(BUFFER_RESERVE);
+}
+
+VMWriter::VMWriter()
+	:m_Ofs(nullptr)
+{
+	m_Buffer.reserve(BUFFER_RESERVE);
+}
 
 VMWriter::~VMWriter()
 {
@@ -12,12 +24,18 @@ VMWriter::~VMWriter()
 
 void VMWriter::WritePush(Segment sgmt, int index)
 {
-	m_Ofs << "push" << SegmentToStr(sgmt) << index << std::endl;
+	Append("push");
+	Append(SegmentToStr(sgmt));
+	Append(index);
+	Append("\n");
 }
 
 void VMWriter::WritePop(Segment sgmt, int index)
 {
-	m_Ofs << "pop" << SegmentToStr(sgmt) << index << std::endl;
+	Append("pop");
+	Append(SegmentToStr(sgmt));
+	Append(index);
+	Append("\n");
 }
 
 void VMWriter::WriteArithmetic(Command cmd)
@@ -25,69 +43,155 @@ void VMWriter::WriteArithmetic(Command cmd)
 	switch (cmd)
 	{
 	case Command::ADD:
-		m_Ofs << "add" << std::endl;
+		Append("add\n");
 		break;
 	case Command::AND:
-		m_Ofs << "and" << std::endl;
+		Append("and\n");
 		break;
 	case Command::EQ:
-		m_Ofs << "eq" << std::endl;
+		Append("eq\n");
 		break;
 	case Command::GT:
-		m_Ofs << "gt" << std::endl;
+		Append("gt\n");
 		break;
 	case Command::LT:
-		m_Ofs << "lt" << std::endl;
+		Append("lt\n");
 		break;
 	case Command::NEG:
-		m_Ofs << "neg" << std::endl;
+		Append("neg\n");
 		break;
 	case Command::NOT:
-		m_Ofs << "not" << std::endl;
+		Append("not\n");
 		break;
 	case Command::OR:
-		m_Ofs << "or" << std::endl;
+		Append("or\n");
 		break;
 	case Command::SUB:
-		m_Ofs << "sub" << std::endl;
+		Append("sub\n");
 		break;
 	}
 }
 
-void VMWriter::WriteLabel(const std::string& label)
+void VMWriter::WriteLabel(std::string_view label)
 {
-	m_Ofs << "label " << label << std::endl;
+	Append("label ");
+	Append(label);
+	Append("\n");
 }
 
-void VMWriter::WriteGoto(const std::string& label)
+void VMWriter::WriteGoto(std::string_view label)
 {
-	m_Ofs << "goto " << label << std::endl;
+	Append("goto ");
+	Append(label);
+	Append("\n");
 }
 
-void VMWriter::WriteIf(const std::string& label)
+void VMWriter::WriteIf(std::string_view label)
 {
-	m_Ofs << "if-goto " << label << std::endl;
+	Append("if-goto ");
+	Append(label);
+	Append("\n");
 }
 
-void VMWriter::WriteCall(const std::string& name, int nArgs)
+void VMWriter::WriteIfCompare(Comparison cmp, std::string_view label)
 {
-	m_Ofs << "call " << name << " " << nArgs << std::endl;
+	switch (cmp)
+	{
+	case Comparison::EQ:
+		Append("if-eq ");
+		break;
+	case Comparison::NE:
+		Append("if-ne ");
+		break;
+	case Comparison::LT:
+		Append("if-lt ");
+		break;
+	case Comparison::GT:
+		Append("if-gt ");
+		break;
+	case Comparison::LE:
+		Append("if-le ");
+		break;
+	case Comparison::GE:
+		Append("if-ge ");
+		break;
+	}
+	Append(label);
+	Append("\n");
 }
 
-void VMWriter::WriteFunction(const std::string& name, int nLocals)
+void VMWriter::WriteInc(Segment sgmt, int index)
 {
-	m_Ofs << "function " << name << " " << nLocals << std::endl;
+	Append("inc");
+	Append(SegmentToStr(sgmt));
+	Append(index);
+	Append("\n");
+}
+
+void VMWriter::WriteDec(Segment sgmt, int index)
+{
+	Append("dec");
+	Append(SegmentToStr(sgmt));
+	Append(index);
+	Append("\n");
+}
+
+void VMWriter::WriteMove(Segment src, int srcIndex, Segment dst, int dstIndex)
+{
+	Append("move");
+	Append(SegmentToStr(src));
+	Append(srcIndex);
+	Append(SegmentToStr(dst));
+	Append(dstIndex);
+	Append("\n");
+}
+
+void VMWriter::WritePushArithmetic(Command cmd, Segment sgmt, int index)
+{
+	Append(cmd == Command::SUB ? "push-sub" : "push-add");
+	Append(SegmentToStr(sgmt));
+	Append(index);
+	Append("\n");
+}
+
+void VMWriter::WriteCall(std::string_view name, int nArgs)
+{
+	Append("call ");
+	Append(name);
+	Append(" ");
+	Append(nArgs);
+	Append("\n");
+}
+
+void VMWriter::WriteFunction(std::string_view name, int nLocals)
+{
+	Append("function ");
+	Append(name);
+	Append(" ");
+	Append(nLocals);
+	Append("\n");
 }
 
 void VMWriter::WriteReturn()
 {
-	m_Ofs << "return" << std::endl;
+	Append("return\n");
 }
 
 void VMWriter::Close()
 {
-	if (m_Ofs.is_open())
-		m_Ofs.close();
+	if (m_Ofs && m_Ofs->is_open())
+	{
+		m_Ofs->write(m_Buffer.data(), m_Buffer.size());
+		m_Buffer.clear();
+		m_Ofs->close();
+	}
+}
+
+void VMWriter::Append(int n)
+{
+	char digits[12];
+	char* end = std::to_chars(std::begin(digits), std::end(digits), n).ptr;
+	m_Buffer.append(digits, end);
 }
 
 const char* const VMWriter::SegmentToStr(Segment sgmt)
@@ -115,4 +219,4 @@ const char* const VMWriter::SegmentToStr(Segment sgmt)
 	return "";
 }
 
-} // namespace jack
\ No newline at end of file
+} // namespace jack
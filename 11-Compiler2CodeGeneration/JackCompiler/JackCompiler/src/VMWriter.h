@@ -1,11 +1,16 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <fstream>
 
 namespace jack
 {
 /*
 * Emits VM commands to an output file.
+*
+* Commands are appended to an in-memory buffer, with integers formatted
+* by std::to_chars, and written to the file in one go when the writer is
+* closed. A writer without a file keeps the whole output in memory.
 */
 class VMWriter
 {
@@ -18,22 +23,46 @@ public:
 	enum class Command {
 		ADD, SUB, NEG, EQ, GT, LT, AND, OR, NOT
 	};
+	// Comparisons of the extended VM's conditional jumps, e.g. "if-lt label".
+	enum class Comparison {
+		EQ, NE, LT, GT, LE, GE
+	};
 public:
 	VMWriter(std::ofstream& ofs);
+	// Output is only kept in memory; see Output().
+	VMWriter();
 	~VMWriter();	// Release resources.
 	void WritePush(Segment sgmt, int index);
 	void WritePop(Segment sgmt, int index);
 	void WriteArithmetic(Command cmd);
-	void WriteLabel(const std::string& label);
-	void WriteGoto(const std::string& label);
-	void WriteIf(const std::string& label);
-	void WriteCall(const std::string& name, int nArgs);
-	void WriteFunction(const std::string& name, int nLocals);
+	void WriteLabel(std::string_view label);
+	void WriteGoto(std::string_view label);
+	void WriteIf(std::string_view label);
+	// Pops y and x and jumps to label if x compares to y as cmp says; extended VM only.
+	void WriteIfCompare(Comparison cmp, std::string_view label);
+	/*
+	* Fused commands of the extended VM. inc and dec add 1 to or subtract 1
+	* from sgmt[index] in place; move copies src[srcIndex] to dst[dstIndex]
+	* without going through the stack; push-add and push-sub add sgmt[index]
+	* to, or subtract it from, the value on top of the stack.
+	*/
+	void WriteInc(Segment sgmt, int index);
+	void WriteDec(Segment sgmt, int index);
+	void WriteMove(Segment src, int srcIndex, Segment dst, int dstIndex);
+	// cmd is ADD or SUB.
+	void WritePushArithmetic(Command cmd, Segment sgmt, int index);
+	void WriteCall(std::string_view name, int nArgs);
+	void WriteFunction(std::string_view name, int nLocals);
 	void WriteReturn();
-	void Close();	// Close Output file.
+	void Close();	// Write buffered commands and close output file.
+	// VM commands written so far and not yet flushed to a file.
+	const std::string& Output() const { return m_Buffer; }
 private:
-	// Outfile file stream with result of generated VM commands.
-	std::ofstream& m_Ofs;
+	// Outfile file stream with result of generated VM commands, if any.
+	std::ofstream* m_Ofs;
+	std::string m_Buffer;
 	static const char* const SegmentToStr(Segment sgmt);
+	void Append(std::string_view text) { m_Buffer.append(text); }
+	void Append(int n);
 };
-} // namespace jack
\ No newline at end of file
+} // namespace jack